@@ -2,6 +2,7 @@
 #include <conio.h> // for _kbhit() and _getch()
 #include <sstream>
 #include <iomanip>
+#include <ctime>
 #include <vector>
 #include <algorithm>
 #include "net_common.h"
@@ -17,6 +18,7 @@ std::string currentInput;
 
 // Global variables moved to private section of CustomClient class
 std::map<uint32_t, std::string> m_chatHistories; // Chat histories with other users
+std::map<uint32_t, uint32_t> m_olderHistoryCursors; // Cursor of the next older history page per user (0 - none)
 bool m_waitingForHistory = false; // Flag indicating waiting for chat history
 
 class CustomClient : public olc::net::client_interface<CustomMsgTypes>
@@ -161,22 +163,16 @@ public:
             return false;
         }
 
-        if (text.size() > MAX_MESSAGE_SIZE) {
-            std::cout << "Error: message too large! Maximum size is " << MAX_MESSAGE_SIZE << " characters" << std::endl;
+        if (text.size() > MAX_CHAT_TEXT_SIZE) {
+            std::cout << "Error: message too large! Maximum size is " << MAX_CHAT_TEXT_SIZE << " characters" << std::endl;
             return false;
         }
 
         olc::net::message<CustomMsgTypes> msg;
         msg.header.id = CustomMsgTypes::GlobalMessage;
 
-        // Add message text size
-        uint32_t textSize = static_cast<uint32_t>(text.size());
-        msg << textSize;
-
-        // Add message text character by character
-        for (const char& c : text) {
-            msg << c;
-        }
+        // Add length-prefixed message text
+        msg << text;
 
         std::cout << "Sending global message: " << text << std::endl;
         return send(msg);
@@ -203,6 +199,20 @@ public:
         return send(msg);
     }
 
+    // Method for requesting the server statistics report (only answered for users with admin rights)
+    bool RequestServerStats() {
+        if (!isConnected()) {
+            std::cout << "Error: not connected to server" << std::endl;
+            return false;
+        }
+
+        olc::net::message<CustomMsgTypes> msg;
+        msg.header.id = CustomMsgTypes::StatsRequest;
+
+        std::cout << "Requesting server statistics..." << std::endl;
+        return send(msg);
+    }
+
     // Interface for sending global messages
     void SendGlobalMessageInterface() {
         if (!isAuthenticated()) {
@@ -244,8 +254,8 @@ public:
     }
 
 public:
-    // Method for requesting chat history with a specific user
-    bool RequestChatHistory(uint32_t otherUserID) {
+    // Method for requesting a page of chat history with a specific user (the newest page by default)
+    bool RequestChatHistory(uint32_t otherUserID, uint32_t beforeSeq = CHAT_HISTORY_LATEST) {
         if (!isConnected()) {
             std::cout << "Error: not connected to server" << std::endl;
             return false;
@@ -264,6 +274,8 @@ public:
         olc::net::message<CustomMsgTypes> msg;
         msg.header.id = CustomMsgTypes::ChatHistoryRequest;
         msg << otherUserID;
+        msg << beforeSeq;
+        msg << CHAT_HISTORY_PAGE_SIZE;
 
         m_waitingForHistory = true;
         std::cout << "Requesting chat history with user #" << otherUserID << "..." << std::endl;
@@ -271,6 +283,35 @@ public:
         return send(msg);
     }
 
+    // Renders count binary history entries from msg as "[time] sender: text" lines appended to out
+    // Returns false if the entries are malformed
+    bool RenderHistoryEntries(olc::net::message<CustomMsgTypes>& msg, uint32_t count, const char* timeFormat, std::string& out) {
+        for (uint32_t i = 0; i < count; i++) {
+            uint64_t messageID = 0;
+            uint32_t senderUserID = 0;
+            uint32_t timestamp = 0;
+            std::string text;
+            if (!msg.readBytes(&messageID, sizeof(messageID)) ||
+                !msg.readBytes(&senderUserID, sizeof(senderUserID)) ||
+                !msg.readBytes(&timestamp, sizeof(timestamp)) ||
+                !msg.readString(text, MAX_CHAT_TEXT_SIZE)) {
+                return false;
+            }
+
+            std::time_t sendTime = timestamp;
+            std::tm tm = {};
+            localtime_s(&tm, &sendTime);
+
+            char timeStr[32];
+            std::strftime(timeStr, sizeof(timeStr), timeFormat, &tm);
+
+            out += "[" + std::string(timeStr) + "] ";
+            out += senderUserID == m_myID ? std::string("You") : "User #" + std::to_string(senderUserID);
+            out += ": " + text + "\n";
+        }
+        return true;
+    }
+
     // Method for displaying chat history
     void DisplayChatHistory(uint32_t otherUserID, const std::string& historyJson) {
         std::cout << "\n=========================================" << std::endl;
@@ -403,8 +444,8 @@ public:
             return false;
         }
 
-        if (text.size() > MAX_MESSAGE_SIZE) {
-            std::cout << "Error: Message too large! Maximum size is " << MAX_MESSAGE_SIZE << " characters." << std::endl;
+        if (text.size() > MAX_CHAT_TEXT_SIZE) {
+            std::cout << "Error: Message too large! Maximum size is " << MAX_CHAT_TEXT_SIZE << " characters." << std::endl;
             return false;
         }
 
@@ -436,15 +477,8 @@ public:
         // First write recipient ID
         msg << clientID;
 
-        // Then write message size
-        uint32_t textSize = static_cast<uint32_t>(text.size());
-        msg << textSize;
-
-        // Add each character of the string to the message
-        for (const char& c : text)
-        {
-            msg << c;
-        }
+        // Then write length-prefixed message text
+        msg << text;
 
         std::cout << "Sending direct message to client #" << clientID << ": " << text << std::endl;
         return send(msg);
@@ -588,8 +622,8 @@ public:
         }
 
         // Check message size limit
-        if (message.size() > MAX_MESSAGE_SIZE) {
-            std::cout << "Error: Message too large! Maximum size is " << MAX_MESSAGE_SIZE << " characters." << std::endl;
+        if (message.size() > MAX_CHAT_TEXT_SIZE) {
+            std::cout << "Error: Message too large! Maximum size is " << MAX_CHAT_TEXT_SIZE << " characters." << std::endl;
             return;
         }
 
@@ -651,8 +685,8 @@ public:
         }
 
         // Check message size limit
-        if (text.size() > MAX_MESSAGE_SIZE) {
-            std::cout << "Error: Message too large! Maximum size is " << MAX_MESSAGE_SIZE << " characters." << std::endl;
+        if (text.size() > MAX_CHAT_TEXT_SIZE) {
+            std::cout << "Error: Message too large! Maximum size is " << MAX_CHAT_TEXT_SIZE << " characters." << std::endl;
             return false;
         }
 
@@ -663,14 +697,8 @@ public:
         // Add recipient ID
         msg << m_activeChat;
 
-        // Add message size
-        uint32_t textSize = static_cast<uint32_t>(text.size());
-        msg << textSize;
-
-        // Add message content character by character
-        for (const char& c : text) {
-            msg << c;
-        }
+        // Add length-prefixed message content
+        msg << text;
 
         return send(msg);
     }
@@ -713,6 +741,18 @@ public:
         RequestChatHistory(clientID);
     }
 
+    // Method to load the page of chat history before the one last received in the active chat
+    void RequestOlderChatHistory() {
+        auto it = m_olderHistoryCursors.find(m_activeChat);
+        if (it == m_olderHistoryCursors.end() || it->second == 0) {
+            std::cout << "\nNo earlier messages in this chat." << std::endl;
+            return;
+        }
+
+        m_chatHistoryDisplayed = false; // Show the page when it arrives
+        RequestChatHistory(m_activeChat, it->second);
+    }
+
     // Method to exit chat mode
     void EndChat() {
         if (m_inChatMode) {
@@ -832,24 +872,12 @@ public:
                     uint32_t senderUserID = 0;
                     owned_msg.msg >> senderUserID;
 
-                    // Read message size
-                    uint32_t messageSize = 0;
-                    owned_msg.msg >> messageSize;
-
-                    // Validate message size
-                    if (messageSize > MAX_MESSAGE_SIZE) {
-                        std::cerr << "Global message too large: " << messageSize << std::endl;
+                    // Read and validate the length-prefixed message text
+                    std::string messageText;
+                    if (!owned_msg.msg.readString(messageText, MAX_CHAT_TEXT_SIZE)) {
+                        std::cerr << "Global message too large or malformed" << std::endl;
                         break;
                     }
-                    // Read the size of the message text
-                std::string messageText;
-                messageText.reserve(messageSize);
-
-                for (uint32_t i = 0; i < messageSize; i++) {
-                    char c;
-                    owned_msg.msg >> c;
-                    messageText.push_back(c);
-                }
 
                 // Display the global message with sender information
                 DisplayGlobalMessage(senderUserID, messageText);
@@ -861,25 +889,19 @@ public:
             {
                 std::cout << "[CLIENT] Received global chat history response" << std::endl;
 
-                // Read the size of the history data
-                uint32_t historySize = 0;
-                owned_msg.msg >> historySize;
+                // Render the binary history entries, each text validated against the message size limit
+                uint32_t messageCount = 0;
+                owned_msg.msg >> messageCount;
 
-                // Validate the history size to prevent buffer overflow
-                if (historySize > 50000) { // Reasonable limit for history
-                    std::cerr << "Global chat history too large: " << historySize << std::endl;
-                    break;
+                std::string chatHistory = "\n=== CHAT HISTORY ===\n";
+                if (messageCount == 0) {
+                    chatHistory += "No messages found.\n";
                 }
-
-                // Read the chat history character by character
-                std::string chatHistory;
-                chatHistory.reserve(historySize);
-
-                for (uint32_t i = 0; i < historySize; i++) {
-                    char c;
-                    owned_msg.msg >> c;
-                    chatHistory.push_back(c);
+                if (!RenderHistoryEntries(owned_msg.msg, messageCount, "%Y-%m-%d %H:%M:%S", chatHistory)) {
+                    std::cerr << "Global chat history malformed" << std::endl;
+                    break;
                 }
+                chatHistory += "=== END OF HISTORY ===\n";
 
                 // Store the received history
                 m_globalChatHistory = chatHistory;
@@ -914,28 +936,32 @@ public:
                 uint32_t otherUserID = 0;
                 owned_msg.msg >> otherUserID;
 
-                // Read the size of the history data
-                uint32_t historySize = 0;
-                owned_msg.msg >> historySize;
-
-                // Validate the history size to prevent buffer overflow
-                if (historySize > MAX_MESSAGE_SIZE) {
-                    std::cerr << "Chat history too large: " << historySize << std::endl;
-                    break;
+                // Page position: cursor for loading older messages, conversation size and entries in this page
+                uint32_t olderCursor = 0;
+                uint32_t totalMessages = 0;
+                uint32_t messageCount = 0;
+                owned_msg.msg >> olderCursor;
+                owned_msg.msg >> totalMessages;
+                owned_msg.msg >> messageCount;
+
+                // Render the binary history entries, each text validated against the message size limit
+                std::string chatHistory = "=== Chat History ===\n\n";
+                if (olderCursor > 0) {
+                    chatHistory += "(Messages " + std::to_string(olderCursor + 1) + "-" + std::to_string(olderCursor + messageCount) +
+                        " of " + std::to_string(totalMessages) + ", type '/older' for earlier messages)\n\n";
                 }
-
-                // Read the private chat history character by character
-                std::string chatHistory;
-                chatHistory.reserve(historySize);
-
-                for (uint32_t i = 0; i < historySize; i++) {
-                    char c;
-                    owned_msg.msg >> c;
-                    chatHistory.push_back(c);
+                if (messageCount == 0) {
+                    chatHistory += "No messages in this chat yet.\n";
+                }
+                if (!RenderHistoryEntries(owned_msg.msg, messageCount, "%H:%M:%S", chatHistory)) {
+                    std::cerr << "Chat history malformed" << std::endl;
+                    break;
                 }
+                chatHistory += "\n=== End of History ===";
 
                 // Store the received history for this user
                 m_chatHistories[otherUserID] = chatHistory;
+                m_olderHistoryCursors[otherUserID] = olderCursor;
                 m_waitingForHistory = false;
 
                 // Display history only if we're in chat mode with this user and haven't shown it yet
@@ -952,6 +978,97 @@ public:
                 break;
             }
 
+            case CustomMsgTypes::HistoryChunk:
+            {
+                uint32_t streamID = 0;
+                uint32_t responseType = 0;
+                uint32_t chunkIndex = 0;
+                uint32_t chunkCount = 0;
+                owned_msg.msg >> streamID;
+                owned_msg.msg >> responseType;
+                owned_msg.msg >> chunkIndex;
+                owned_msg.msg >> chunkCount;
+
+                bool firstChunk = chunkIndex == 0;
+                bool lastChunk = chunkIndex + 1 >= chunkCount;
+
+                // Each chunk is a complete response body holding part of the entries; render it on arrival
+                std::string chunkText;
+                bool visible = false;
+                if (responseType == static_cast<uint32_t>(CustomMsgTypes::GlobalChatHistoryResponse)) {
+                    uint32_t messageCount = 0;
+                    owned_msg.msg >> messageCount;
+
+                    if (firstChunk) {
+                        chunkText = "\n=== CHAT HISTORY ===\n";
+                        m_globalChatHistory.clear();
+                    }
+                    // A malformed chunk is still acknowledged below, otherwise the rest of the stream never arrives
+                    if (!RenderHistoryEntries(owned_msg.msg, messageCount, "%Y-%m-%d %H:%M:%S", chunkText)) {
+                        std::cerr << "Global chat history chunk malformed" << std::endl;
+                        chunkText += "(part of the history could not be displayed)\n";
+                    }
+                    if (lastChunk) {
+                        chunkText += "=== END OF HISTORY ===\n";
+                        m_waitingForGlobalHistory = false;
+                    }
+
+                    m_globalChatHistory += chunkText;
+                    visible = m_inGlobalChatMode || !isInChatMode();
+                }
+                else if (responseType == static_cast<uint32_t>(CustomMsgTypes::ChatHistoryResponse)) {
+                    uint32_t otherUserID = 0;
+                    uint32_t olderCursor = 0;
+                    uint32_t totalMessages = 0;
+                    uint32_t messageCount = 0;
+                    owned_msg.msg >> otherUserID;
+                    owned_msg.msg >> olderCursor;
+                    owned_msg.msg >> totalMessages;
+                    owned_msg.msg >> messageCount;
+
+                    if (firstChunk) {
+                        chunkText = "\n=== Chat History ===\n\n";
+                        if (olderCursor > 0) {
+                            chunkText += "(Messages from " + std::to_string(olderCursor + 1) + " of " + std::to_string(totalMessages) +
+                                ", type '/older' for earlier messages)\n\n";
+                        }
+                        m_chatHistories[otherUserID].clear();
+                        m_olderHistoryCursors[otherUserID] = olderCursor;
+                    }
+                    if (!RenderHistoryEntries(owned_msg.msg, messageCount, "%H:%M:%S", chunkText)) {
+                        std::cerr << "Chat history chunk malformed" << std::endl;
+                        chunkText += "(part of the history could not be displayed)\n";
+                    }
+                    if (lastChunk) {
+                        chunkText += "\n=== End of History ===\n";
+                        m_waitingForHistory = false;
+                        if (isInChatMode() && m_activeChat == otherUserID)
+                            m_chatHistoryDisplayed = true;
+                    }
+
+                    m_chatHistories[otherUserID] += chunkText;
+                    visible = !isInChatMode() || m_activeChat == otherUserID;
+                }
+
+                if (visible) {
+                    std::cout << chunkText;
+                    if (lastChunk) {
+                        if (isInChatMode() || m_inGlobalChatMode)
+                            std::cout << "> " << currentInput;
+                        else
+                            DisplayMenu(isAuthenticated());
+                    }
+                    std::cout.flush();
+                }
+
+                // Let the server release the next chunk of the stream
+                olc::net::message<CustomMsgTypes> ack;
+                ack.header.id = CustomMsgTypes::HistoryChunkAck;
+                ack << streamID;
+                send(ack);
+                break;
+            }
+
 
 
             case CustomMsgTypes::ChatRequest:
@@ -972,44 +1089,20 @@ public:
                 uint32_t clientID = 0;
                 owned_msg.msg >> clientID;
 
-                // Extract the size of the username
-                uint32_t usernameSize = 0;
-                owned_msg.msg >> usernameSize;
-
-                // Validate username size to prevent buffer overflow
-                if (usernameSize > MAX_MESSAGE_SIZE) {
+                // Read the username, validating its size to prevent buffer overflow
+                std::string username;
+                if (!owned_msg.msg.readString(username, MAX_MESSAGE_SIZE)) {
                     std::cerr << "Incorrect size of username" << std::endl;
                     break;
                 }
 
-                // Read the username character by character
-                std::string username;
-                username.reserve(usernameSize);
-                for (uint32_t i = 0; i < usernameSize; i++) {
-                    char c;
-                    owned_msg.msg >> c;
-                    username.push_back(c);
-                }
-
-                // Extract the size of the status
-                uint32_t statusSize = 0;
-                owned_msg.msg >> statusSize;
-
-                // Validate status size to prevent buffer overflow
-                if (statusSize > MAX_MESSAGE_SIZE) {
+                // Read the status, validating its size to prevent buffer overflow
+                std::string status;
+                if (!owned_msg.msg.readString(status, MAX_MESSAGE_SIZE)) {
                     std::cerr << "Incorrect size of status" << std::endl;
                     break;
                 }
 
-                // Read the status character by character
-                std::string status;
-                status.reserve(statusSize);
-                for (uint32_t i = 0; i < statusSize; i++) {
-                    char c;
-                    owned_msg.msg >> c;
-                    status.push_back(c);
-                }
-
                 // Display the client information
                 DisplayClientInfo(clientID, username, status);
 
@@ -1066,6 +1159,7 @@ public:
                     std::cout << "=======================================" << std::endl;
                     std::cout << "Type your messages and press Enter to send." << std::endl;
                     std::cout << "Type '/exit' to end the chat." << std::endl;
+                    std::cout << "Type '/older' to load earlier messages." << std::endl;
                     std::cout << "\n> ";
                     currentInput = "";
                 }
@@ -1110,33 +1204,34 @@ public:
                 std::cout << "Server denied connection!" << std::endl;
                 break;
 
+            case CustomMsgTypes::StatsResponse:
+            {
+                // The report is preformatted text, shown as it is
+                std::string report;
+                if (!owned_msg.msg.readString(report)) {
+                    std::cerr << "Incorrect size" << std::endl;
+                    break;
+                }
+
+                std::cout << "\n=== SERVER STATISTICS ===" << std::endl;
+                std::cout << report;
+                std::cout << "=========================" << std::endl;
+                break;
+            }
+
             case CustomMsgTypes::RegisterResponse:
             {
                 // Get success flag
                 bool success = false;
                 owned_msg.msg >> success;
 
-                // Read message size
-                uint32_t messageSize = 0;
-                owned_msg.msg >> messageSize;
-
-                // Security check to prevent buffer overflow
-                if (messageSize > MAX_MESSAGE_SIZE) {
+                // Read message, security check to prevent buffer overflow
+                std::string message;
+                if (!owned_msg.msg.readString(message, MAX_MESSAGE_SIZE)) {
                     std::cerr << "Incorrect size" << std::endl;
                     break;
                 }
 
-                // Read message character by character
-                std::string message;
-                message.reserve(messageSize);
-
-                for (uint32_t i = 0; i < messageSize; i++)
-                {
-                    char c;
-                    owned_msg.msg >> c;
-                    message.push_back(c);
-                }
-
                 // Display registration result in a formatted box
                 std::cout << "?????????????????????????????????????????" << std::endl;
                 std::cout << "?     Result of registration            ?" << std::endl;
@@ -1163,32 +1258,12 @@ public:
 
             case CustomMsgTypes::ServerMessage:
             {
-                // Read message size
-                uint32_t messageSize = 0;
-                owned_msg.msg >> messageSize;
-
-                // Check size correctness to prevent buffer overflow
-                if (messageSize > MAX_MESSAGE_SIZE) {
-                    std::cerr << "Server message too large: " << messageSize << std::endl;
-                    break;
-                }
-
-                // Security check: ensure message size doesn't exceed body size
-                if (messageSize > owned_msg.msg.body.size()) {
-                    std::cerr << "Invalid message size: declared " << messageSize
-                        << " but body only has " << owned_msg.msg.body.size() << " bytes" << std::endl;
-                    break;
-                }
-
-                // Read message character by character
+                // Read message, checking size correctness against the limit and the body size
                 std::string message;
-                message.reserve(messageSize); // Memory allocation optimization
-
-                for (uint32_t i = 0; i < messageSize; i++)
-                {
-                    char c;
-                    owned_msg.msg >> c;
-                    message.push_back(c);
+                if (!owned_msg.msg.readString(message, MAX_MESSAGE_SIZE)) {
+                    std::cerr << "Server message too large or malformed (body has "
+                        << owned_msg.msg.body.size() << " bytes)" << std::endl;
+                    break;
                 }
 
                 // Check if message is client list and display accordingly
@@ -1208,27 +1283,13 @@ public:
                 bool success = false;
                 owned_msg.msg >> success;
 
-                // Read the size of the response message
-                uint32_t messageSize = 0;
-                owned_msg.msg >> messageSize;
-
-                // Security check: validate message size to prevent buffer overflow
-                if (messageSize > MAX_MESSAGE_SIZE) {
+                // Read the response message, validating its size to prevent buffer overflow
+                std::string message;
+                if (!owned_msg.msg.readString(message, MAX_MESSAGE_SIZE)) {
                     std::cerr << "Incorrect message size" << std::endl;
                     break;
                 }
 
-                // Read the message content character by character
-                std::string message;
-                message.reserve(messageSize);
-
-                for (uint32_t i = 0; i < messageSize; i++)
-                {
-                    char c;
-                    owned_msg.msg >> c;
-                    message.push_back(c);
-                }
-
                 // Update client authentication status based on server response
                 m_isAuthenticated = success;
 
@@ -1262,27 +1323,13 @@ public:
                 uint32_t senderID = 0;
                 owned_msg.msg >> senderID;
 
-                // Read message size
-                uint32_t messageSize = 0;
-                owned_msg.msg >> messageSize;
-
-                // Security validation: check message size bounds
-                if (messageSize > MAX_MESSAGE_SIZE || messageSize > owned_msg.msg.body.size()) {
+                // Read message content, security validation of size bounds
+                std::string message;
+                if (!owned_msg.msg.readString(message, MAX_CHAT_TEXT_SIZE)) {
                     std::cerr << "Incorrect size of private message" << std::endl;
                     break;
                 }
 
-                // Read message content character by character
-                std::string message;
-                message.reserve(messageSize);
-
-                for (uint32_t i = 0; i < messageSize; i++)
-                {
-                    char c;
-                    owned_msg.msg >> c;
-                    message.push_back(c);
-                }
-
                 // Store sender ID for potential reply functionality
                 m_lastMessageSender = senderID;
 
@@ -1383,6 +1430,11 @@ int main()
                                 currentInput = "";
                                 std::cout << "\n> ";
                             }
+                            else if (currentInput == "/older" && c.isInChatMode()) {
+                                c.RequestOlderChatHistory();
+                                currentInput = "";
+                                std::cout << "\n> ";
+                            }
                             else {
                                 // Send message based on current chat mode
                                 if (c.isInGlobalChatMode()) {
@@ -1449,6 +1501,7 @@ int main()
                                 std::cout << "=======================================" << std::endl;
                                 std::cout << "Type your messages and press Enter to send." << std::endl;
                                 std::cout << "Type '/exit' to end the chat." << std::endl;
+                                std::cout << "Type '/older' to load earlier messages." << std::endl;
                                 std::cout << "\n> ";
                                 currentInput = "";
                             }
@@ -1511,6 +1564,16 @@ int main()
                         }
                         break;
 
+                    case 'S': // Request server statistics
+                        if (c.isAuthenticated()) {
+                            c.RequestServerStats();
+                        }
+                        else {
+                            std::cout << "You must be logged in to view server statistics" << std::endl;
+                            DisplayMenu(c.isAuthenticated());
+                        }
+                        break;
+
                     case 'Q': // Quit application
                         bQuit = true;
                         break;
@@ -29,12 +29,29 @@ enum class CustomMsgTypes : uint32_t
     ChatHistoryResponse,    // Response with chat history
     GlobalMessage,          // Global message broadcast
     GlobalChatHistoryRequest,  // Request for global chat history
-    GlobalChatHistoryResponse  // Response with global chat history
+    GlobalChatHistoryResponse, // Response with global chat history
+    HistoryChunk,           // One part of a large history response
+    HistoryChunkAck,        // Acknowledges a processed history chunk
+    StatsRequest,           // Request for the server statistics report (admin only)
+    StatsResponse           // Server statistics report
 };
 
 // Maximum allowed message size in bytes
 const size_t MAX_MESSAGE_SIZE = 8192;
 
+// Largest chat text (global, direct and history entries); must match MAX_CHAT_TEXT_SIZE on the server
+const uint32_t MAX_CHAT_TEXT_SIZE = 10000;
+
+// Chat history paging: a ChatHistoryRequest carries [uint32 beforeSeq][uint32 limit] after the user ID
+// History responses carry binary entries, rendered by the client:
+//   ChatHistoryResponse:       [uint32 partner ID][uint32 older cursor, 0 = none][uint32 total][uint32 count][entries]
+//   GlobalChatHistoryResponse: [uint32 count][entries]
+//   Entry: [uint64 message ID][uint32 sender user ID][uint32 send time, seconds since epoch][uint32 text length][text]
+// Large responses arrive as HistoryChunk frames, each answered with HistoryChunkAck [uint32 stream ID]:
+//   [uint32 stream ID][uint32 response type][uint32 chunk index][uint32 chunk count][response body with this chunk's entries]
+const uint32_t CHAT_HISTORY_LATEST = UINT32_MAX;  // Cursor value asking for the newest page
+const uint32_t CHAT_HISTORY_PAGE_SIZE = 50;       // Messages requested per page
+
 /**
  * Displays the client menu interface
  * @param isAuthenticated - whether the user is logged in or not
@@ -50,6 +67,7 @@ void DisplayMenu(bool isAuthenticated)
         std::cout << "? G - send global message     ?" << std::endl;
         std::cout << "? H - global chat history     ?" << std::endl;
         std::cout << "? I - user information        ?" << std::endl;
+        std::cout << "? S - server statistics       ?" << std::endl;
     }
     else {
         std::cout << "? R - registration            ?" << std::endl;
@@ -274,19 +292,9 @@ namespace olc
                 olc::net::message<CustomMsgTypes> msg;
                 msg.header.id = CustomMsgTypes::LoginRequest;
 
-                // Pack username size and characters into message
-                uint32_t usernameSize = static_cast<uint32_t>(username.size());
-                msg << usernameSize;
-                for (const char& c : username) {
-                    msg << c;
-                }
-
-                // Pack password size and characters into message
-                uint32_t passwordSize = static_cast<uint32_t>(password.size());
-                msg << passwordSize;
-                for (const char& c : password) {
-                    msg << c;
-                }
+                // Pack length-prefixed username and password into message
+                msg << username;
+                msg << password;
 
                 std::cout << "Sending login request for user: " << username << std::endl;
                 return send(msg);
@@ -351,26 +359,12 @@ namespace olc
                 olc::net::message<CustomMsgTypes> msg;
                 msg.header.id = CustomMsgTypes::RegisterRequest;
 
-                // Pack username size and characters into message
-                uint32_t usernameSize = static_cast<uint32_t>(username.size());
-                msg << usernameSize;
-                for (const char& c : username) {
-                    msg << c;
-                }
-
-                // Pack password size and characters into message
-                uint32_t passwordSize = static_cast<uint32_t>(password.size());
-                msg << passwordSize;
-                for (const char& c : password) {
-                    msg << c;
-                }
+                // Pack length-prefixed username and password into message
+                msg << username;
+                msg << password;
 
-                // Pack email size and characters into message
-                uint32_t emailSize = static_cast<uint32_t>(email.size());
-                msg << emailSize;
-                for (const char& c : email) {
-                    msg << c;
-                }
+                // Pack length-prefixed email into message
+                msg << email;
 
                 std::cout << "Sending registration request for user: " << username << std::endl;
                 return send(msg);
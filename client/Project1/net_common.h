@@ -7,6 +7,9 @@
 #include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
 
 #ifdef _WIN32
 #define _WIN32_WINNT 0x0A00
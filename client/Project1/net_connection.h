@@ -256,6 +256,11 @@ namespace olc
                 {
                     m_qMessageIn.push_back({ this->shared_from_this(), m_tempMsg });
                 }
+                else if (m_tempMsg.header.id == T::ServerPing)
+                {
+                    // Heartbeats are echoed right here, so a busy or blocked UI loop cannot get the client dropped
+                    send(m_tempMsg);
+                }
                 else
                 {
                     // Client connections add message without connection reference
@@ -88,6 +88,87 @@ namespace olc
                 return msg;
             }
 
+
+            // Appends a block of raw bytes to the message body with a single resize
+            void writeBytes(const void* data, size_t size)
+            {
+                size_t i = body.size();
+                body.resize(body.size() + size);
+                if (size > 0)
+                    std::memcpy(body.data() + i, data, size);
+                header.size = static_cast<uint32_t>(this->size());
+            }
+
+            // Extracts a block of raw bytes from the message body, returns false if not enough data
+            bool readBytes(void* data, size_t size)
+            {
+                if (readPos + size > body.size())
+                {
+                    std::cerr << "Warning: Attempting to read beyond message body!" << std::endl;
+                    return false;
+                }
+
+                if (size > 0)
+                    std::memcpy(data, body.data() + readPos, size);
+                readPos += size;
+                return true;
+            }
+
+            // Appends a string as a uint32_t length prefix followed by its characters
+            void writeString(std::string_view str)
+            {
+                uint32_t length = static_cast<uint32_t>(str.size());
+                size_t i = body.size();
+                body.resize(body.size() + sizeof(uint32_t) + str.size());
+                std::memcpy(body.data() + i, &length, sizeof(uint32_t));
+                if (!str.empty())
+                    std::memcpy(body.data() + i + sizeof(uint32_t), str.data(), str.size());
+                header.size = static_cast<uint32_t>(this->size());
+            }
+
+            // Extracts a length-prefixed string, rejecting lengths above maxSize or beyond the body
+            bool readString(std::string& str, size_t maxSize = SIZE_MAX)
+            {
+                uint32_t length = 0;
+                if (!readBytes(&length, sizeof(uint32_t)))
+                    return false;
+
+                if (length > maxSize || readPos + length > body.size())
+                {
+                    std::cerr << "Warning: Invalid string length in message body: " << length << std::endl;
+                    readPos = body.size();
+                    return false;
+                }
+
+                str.assign(reinterpret_cast<const char*>(body.data()) + readPos, length);
+                readPos += length;
+                return true;
+            }
+
+            // Stream operators for length-prefixed strings (preferred over the trivially-copyable template)
+            friend message<T>& operator << (message<T>& msg, std::string_view str)
+            {
+                msg.writeString(str);
+                return msg;
+            }
+
+            friend message<T>& operator << (message<T>& msg, const std::string& str)
+            {
+                msg.writeString(str);
+                return msg;
+            }
+
+            friend message<T>& operator << (message<T>& msg, const char* str)
+            {
+                msg.writeString(str);
+                return msg;
+            }
+
+            friend message<T>& operator >> (message<T>& msg, std::string& str)
+            {
+                msg.readString(str);
+                return msg;
+            }
         };
 
         // Owned message structure that associates a message with its source connection
@@ -0,0 +1,125 @@
+// Compares the server's incoming queue (mpscQueue) with the tsQueue it replaced
+// N producer threads push message-sized elements while one consumer drains them the way
+// server_interface::update() does. Prints the wall time per message for each queue.
+// mpscQueue is measured twice: parking on wait() as update() does, and yielding when empty
+// like the tsQueue consumer, which separates the cost of the queue from the cost of sleeping.
+//
+// Usage: Benchmark [messages]   (default 2000000, split evenly across the producers)
+
+#include "../Project1/net_tsQueue.h"
+#include "../Project1/net_mpscQueue.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    // Same shape as owned_message<T>: a connection reference and a small body
+    struct Element
+    {
+        std::shared_ptr<int> remote;
+        std::vector<uint8_t> body;
+    };
+
+    template<typename Queue, typename Consume>
+    double run(size_t producers, size_t perProducer, Consume consume)
+    {
+        Queue queue;
+        std::atomic<bool> go{ false };
+        std::vector<std::thread> threads;
+        auto remote = std::make_shared<int>(0);
+
+        for (size_t p = 0; p < producers; p++)
+        {
+            threads.emplace_back([&]()
+                {
+                    while (!go.load(std::memory_order_acquire))
+                        std::this_thread::yield();
+
+                    for (size_t i = 0; i < perProducer; i++)
+                    {
+                        Element element;
+                        element.remote = remote;
+                        element.body.resize(32);
+                        queue.push_back(std::move(element));
+                    }
+                });
+        }
+
+        size_t total = producers * perProducer;
+        auto start = clock_type::now();
+        go.store(true, std::memory_order_release);
+
+        size_t received = 0;
+        while (received < total)
+            received += consume(queue);
+
+        auto elapsed = clock_type::now() - start;
+        for (auto& thread : threads)
+            thread.join();
+
+        return std::chrono::duration<double, std::nano>(elapsed).count() / double(total);
+    }
+
+    // Pre-mpscQueue update(): empty()/front()/pop_front() each take the queue mutex
+    // tsQueue::wait() takes muxBlocking then muxQueue while push_back() takes them in the
+    // opposite order, so it can deadlock under load; the consumer yields when empty instead.
+    size_t consumeTsQueue(olc::net::tsQueue<Element>& queue)
+    {
+        size_t count = 0;
+        while (!queue.empty())
+        {
+            Element element = queue.front();
+            queue.pop_front();
+            count++;
+        }
+        if (count == 0)
+            std::this_thread::yield();
+        return count;
+    }
+
+    size_t drainMpscQueue(olc::net::mpscQueue<Element>& queue)
+    {
+        size_t count = 0;
+        Element element;
+        while (queue.try_pop(element))
+            count++;
+        return count;
+    }
+
+    // Current update(): park until something arrives, then drain without locking
+    size_t consumeMpscQueue(olc::net::mpscQueue<Element>& queue)
+    {
+        queue.wait();
+        return drainMpscQueue(queue);
+    }
+
+    // Same drain, but yield instead of parking when the queue is empty
+    size_t pollMpscQueue(olc::net::mpscQueue<Element>& queue)
+    {
+        size_t count = drainMpscQueue(queue);
+        if (count == 0)
+            std::this_thread::yield();
+        return count;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t messages = argc > 1 ? size_t(std::strtoull(argv[1], nullptr, 10)) : 2000000;
+
+    std::printf("%u hardware threads, %zu messages per run\n", std::thread::hardware_concurrency(), messages);
+    std::printf("producers    tsQueue    mpscQueue (wait)    mpscQueue (poll)    ns/msg\n");
+
+    for (size_t producers : { 1, 2, 4, 8 })
+    {
+        size_t perProducer = messages / producers;
+        double ts = run<olc::net::tsQueue<Element>>(producers, perProducer, consumeTsQueue);
+        double parked = run<olc::net::mpscQueue<Element>>(producers, perProducer, consumeMpscQueue);
+        double polled = run<olc::net::mpscQueue<Element>>(producers, perProducer, pollMpscQueue);
+        std::printf("%9zu    %7.1f    %16.1f    %16.1f\n", producers, ts, parked, polled);
+    }
+
+    return 0;
+}
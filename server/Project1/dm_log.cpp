@@ -0,0 +1,398 @@
+#include "dm_log.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+#include "simdjson.h"
+#include "logger.h"
+
+namespace
+{
+    // Size of the per-record header: payload size + CRC-32
+    const size_t RECORD_HEADER_SIZE = 2 * sizeof(uint32_t);
+
+    // Upper bound for a single record, anything larger is treated as corruption
+    const uint32_t MAX_RECORD_SIZE = 1 << 20;
+
+    // CRC-32 (IEEE 802.3) of a byte range
+    uint32_t crc32(const char* data, size_t size)
+    {
+        static const auto table = [] {
+            std::vector<uint32_t> t(256);
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[i] = c;
+            }
+            return t;
+        }();
+
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; i++)
+            crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    void putU32(std::string& out, uint32_t value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void putU64(std::string& out, uint64_t value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void putString(std::string& out, const std::string& value)
+    {
+        putU32(out, static_cast<uint32_t>(value.size()));
+        out.append(value);
+    }
+
+    // Bounds-checked reader over one record payload
+    struct PayloadReader
+    {
+        const char* pos;
+        const char* end;
+
+        template<typename V>
+        bool get(V& value)
+        {
+            if (size_t(end - pos) < sizeof(V))
+                return false;
+            std::memcpy(&value, pos, sizeof(V));
+            pos += sizeof(V);
+            return true;
+        }
+
+        bool get(std::string& value)
+        {
+            uint32_t size = 0;
+            if (!get(size) || size_t(end - pos) < size)
+                return false;
+            value.assign(pos, size);
+            pos += size;
+            return true;
+        }
+    };
+
+    // Serializes a record with its header
+    std::string encodeRecord(const ChatRecord& record)
+    {
+        std::string payload;
+        putU64(payload, record.messageID);
+        putU32(payload, record.senderUserID);
+        putU32(payload, record.recipientUserID);
+        putString(payload, record.senderUsername);
+        putString(payload, record.recipientUsername);
+        putString(payload, record.timestamp);
+        putString(payload, record.messageText);
+
+        std::string out;
+        out.reserve(RECORD_HEADER_SIZE + payload.size());
+        putU32(out, static_cast<uint32_t>(payload.size()));
+        putU32(out, crc32(payload.data(), payload.size()));
+        out += payload;
+        return out;
+    }
+
+    bool decodeRecord(const char* data, size_t size, ChatRecord& record)
+    {
+        PayloadReader reader{ data, data + size };
+        return reader.get(record.messageID) && reader.get(record.senderUserID) && reader.get(record.recipientUserID) &&
+            reader.get(record.senderUsername) && reader.get(record.recipientUsername) &&
+            reader.get(record.timestamp) && reader.get(record.messageText) && reader.pos == reader.end;
+    }
+
+    // Walks the records in a log image, calling onRecord with the offset of each intact one;
+    // returns the offset just past the last intact record
+    template<typename OnRecord>
+    size_t scanRecords(const std::string& data, OnRecord onRecord)
+    {
+        size_t offset = 0;
+        while (data.size() - offset >= RECORD_HEADER_SIZE) {
+            uint32_t payloadSize = 0;
+            uint32_t checksum = 0;
+            std::memcpy(&payloadSize, data.data() + offset, sizeof(uint32_t));
+            std::memcpy(&checksum, data.data() + offset + sizeof(uint32_t), sizeof(uint32_t));
+
+            if (payloadSize > MAX_RECORD_SIZE || data.size() - offset - RECORD_HEADER_SIZE < payloadSize)
+                break;
+
+            const char* payload = data.data() + offset + RECORD_HEADER_SIZE;
+            if (crc32(payload, payloadSize) != checksum)
+                break;
+
+            onRecord(offset);
+            offset += RECORD_HEADER_SIZE + payloadSize;
+        }
+        return offset;
+    }
+
+    // Reads a file from the given offset to its end
+    bool readFile(const std::string& path, std::string& data, uint64_t offset = 0)
+    {
+        std::ifstream inFile(path, std::ios::binary);
+        if (!inFile.is_open())
+            return false;
+        inFile.seekg(static_cast<std::streamoff>(offset));
+        data.assign(std::istreambuf_iterator<char>(inFile), std::istreambuf_iterator<char>());
+        return true;
+    }
+}
+
+std::string DirectMessageLog::fileName(const std::string& user1, const std::string& user2)
+{
+    // Sort usernames alphabetically for consistent file naming
+    return user1 < user2 ? "chat_" + user1 + "_" + user2 + ".log" : "chat_" + user2 + "_" + user1 + ".log";
+}
+
+std::string DirectMessageLog::indexFileName(const std::string& logPath)
+{
+    return logPath.substr(0, logPath.size() - 4) + ".idx";
+}
+
+bool DirectMessageLog::append(const std::string& user1, const std::string& user2, const ChatRecord& record,
+    PersistenceStage::DurableCallback onDurable)
+{
+    if (!persistence) {
+        LOG_ERROR("[DM_LOG] No persistence stage attached, message not saved");
+        return false;
+    }
+
+    const std::string path = fileName(user1, user2);
+    LogState& state = prepare(path);
+
+    // Queue the checkpoint ahead of the record; a checkpoint past the end of the log is dropped on load
+    if (state.count % INDEX_INTERVAL == 0) {
+        state.checkpoints.push_back(state.size);
+        std::string entry;
+        putU64(entry, state.size);
+        persistence->append(indexFileName(path), std::move(entry));
+    }
+
+    std::string bytes = encodeRecord(record);
+    state.size += bytes.size();
+    state.count++;
+
+    persistence->append(path, std::move(bytes), std::move(onDurable));
+    return true;
+}
+
+DirectMessageLog::PageLocation DirectMessageLog::locatePage(const std::string& user1, const std::string& user2,
+    uint32_t beforeSeq, uint32_t limit)
+{
+    PageLocation location;
+    location.path = fileName(user1, user2);
+    const LogState& state = prepare(location.path);
+
+    location.total = state.count;
+    location.endSeq = std::min(beforeSeq, state.count);
+    location.startSeq = location.endSeq > limit ? location.endSeq - limit : 0;
+    if (location.startSeq < location.endSeq) {
+        // The checkpoint at or before the first wanted record, the read skips forward from there
+        size_t checkpoint = location.startSeq / INDEX_INTERVAL;
+        location.offset = state.checkpoints[checkpoint];
+        location.offsetSeq = static_cast<uint32_t>(checkpoint) * INDEX_INTERVAL;
+    }
+    return location;
+}
+
+uint32_t DirectMessageLog::messageCount(const std::string& user1, const std::string& user2)
+{
+    return prepare(fileName(user1, user2)).count;
+}
+
+ChatPage DirectMessageLog::readPage(const PageLocation& location) const
+{
+    const std::string& path = location.path;
+    const uint32_t startSeq = location.startSeq;
+    const uint32_t endSeq = location.endSeq;
+
+    ChatPage page;
+    page.total = location.total;
+    page.firstSeq = startSeq;
+    if (startSeq == endSeq)
+        return page;
+
+    // Make sure appends still queued for writing are in the file
+    if (persistence)
+        persistence->flush();
+
+    std::ifstream inFile(path, std::ios::binary);
+    if (!inFile.is_open()) {
+        LOG_ERROR("[DM_LOG] Cannot open " << path << " for reading");
+        return page;
+    }
+
+    inFile.seekg(static_cast<std::streamoff>(location.offset));
+
+    uint32_t seq = location.offsetSeq;
+    std::string payload;
+    while (seq < endSeq) {
+        uint32_t header[2] = { 0, 0 };
+        if (!inFile.read(reinterpret_cast<char*>(header), RECORD_HEADER_SIZE) || header[0] > MAX_RECORD_SIZE)
+            break;
+
+        if (seq < startSeq) {
+            inFile.seekg(header[0], std::ios::cur);
+            seq++;
+            continue;
+        }
+
+        payload.resize(header[0]);
+        ChatRecord record;
+        if (!inFile.read(payload.data(), header[0]) || crc32(payload.data(), payload.size()) != header[1] ||
+            !decodeRecord(payload.data(), payload.size(), record))
+            break;
+
+        page.records.push_back(std::move(record));
+        seq++;
+    }
+
+    if (seq < endSeq) {
+        LOG_ERROR("[DM_LOG] " << path << ": record #" << seq << " is damaged, page cut short");
+    }
+    return page;
+}
+
+DirectMessageLog::LogState& DirectMessageLog::prepare(const std::string& path)
+{
+    auto found = logs.find(path);
+    if (found != logs.end())
+        return found->second;
+
+    LogState& state = logs[path];
+    const std::string indexPath = indexFileName(path);
+    std::error_code ec;
+
+    if (!std::filesystem::exists(path, ec)) {
+        // No log yet - carry over the old JSON conversation file if there is one
+        std::string legacyPath = path.substr(0, path.size() - 4) + ".json";
+        if (std::filesystem::exists(legacyPath, ec) && !importLegacyJson(legacyPath, path)) {
+            LOG_ERROR("[DM_LOG] Messages in " << legacyPath << " are not part of " << path
+                << "; the file is kept for manual recovery");
+        }
+        if (!std::filesystem::exists(path, ec)) {
+            std::filesystem::remove(indexPath, ec);
+            return state;
+        }
+    }
+
+    uint64_t fileSize = std::filesystem::file_size(path, ec);
+
+    // Keep the checkpoints that still point inside the log, in increasing order
+    std::string indexData;
+    if (readFile(indexPath, indexData)) {
+        for (size_t pos = 0; pos + sizeof(uint64_t) <= indexData.size(); pos += sizeof(uint64_t)) {
+            uint64_t offset = 0;
+            std::memcpy(&offset, indexData.data() + pos, sizeof(uint64_t));
+            bool ordered = state.checkpoints.empty() ? offset == 0 : offset > state.checkpoints.back();
+            if (!ordered || offset >= fileSize)
+                break;
+            state.checkpoints.push_back(offset);
+        }
+    }
+    const std::vector<uint64_t> loadedCheckpoints = state.checkpoints;
+
+    // Only the records after the last checkpoint are scanned; a checkpoint that does not start an
+    // intact record is dropped and the scan restarts from the one before it
+    std::string tail;
+    for (;;) {
+        uint64_t start = 0;
+        uint32_t count = 0;
+        if (!state.checkpoints.empty()) {
+            start = state.checkpoints.back();
+            count = static_cast<uint32_t>(state.checkpoints.size() - 1) * INDEX_INTERVAL;
+            state.checkpoints.pop_back();
+        }
+
+        readFile(path, tail, start);
+        uint32_t scanned = 0;
+        size_t validTail = scanRecords(tail, [&](size_t offset) {
+            if ((count + scanned) % INDEX_INTERVAL == 0)
+                state.checkpoints.push_back(start + offset);
+            scanned++;
+        });
+
+        if (scanned > 0 || start == 0) {
+            state.count = count + scanned;
+            state.size = start + validTail;
+            break;
+        }
+    }
+
+    // Cut off a record torn by a crash so later appends stay readable
+    if (state.size != fileSize) {
+        LOG_ERROR("[DM_LOG] " << path << ": truncating torn tail at offset " << state.size);
+        std::filesystem::resize_file(path, state.size, ec);
+    }
+
+    // Rewrite the index if the scan changed it or it holds entries that were dropped above
+    if (state.checkpoints != loadedCheckpoints || indexData.size() != loadedCheckpoints.size() * sizeof(uint64_t)) {
+        std::string bytes;
+        for (uint64_t offset : state.checkpoints)
+            putU64(bytes, offset);
+        std::ofstream indexFile(indexPath, std::ios::binary | std::ios::trunc);
+        indexFile.write(bytes.data(), bytes.size());
+        LOG_INFO("[DM_LOG] Rebuilt index " << indexPath << " (" << state.count << " messages)");
+    }
+
+    return state;
+}
+
+bool DirectMessageLog::importLegacyJson(const std::string& jsonPath, const std::string& logPath)
+{
+    try {
+        simdjson::dom::parser parser;
+        simdjson::dom::element doc;
+        if (parser.load(jsonPath).get(doc) != simdjson::SUCCESS) {
+            LOG_ERROR("[DM_LOG] Cannot parse legacy chat file " << jsonPath << ", not imported");
+            return false;
+        }
+
+        simdjson::dom::array messages;
+        if (doc["messages"].get(messages) != simdjson::SUCCESS) {
+            LOG_ERROR("[DM_LOG] Legacy chat file " << jsonPath << " has no \"messages\" array, not imported");
+            return false;
+        }
+
+        std::string bytes;
+        size_t count = 0;
+        for (auto message : messages) {
+            ChatRecord record;
+            std::string_view text;
+            uint64_t number = 0;
+
+            if (message["message_id"].get(number) == simdjson::SUCCESS) record.messageID = number;
+            if (message["sender_user_id"].get(number) == simdjson::SUCCESS) record.senderUserID = static_cast<uint32_t>(number);
+            if (message["recipient_user_id"].get(number) == simdjson::SUCCESS) record.recipientUserID = static_cast<uint32_t>(number);
+            if (message["sender_username"].get(text) == simdjson::SUCCESS) record.senderUsername = std::string(text);
+            if (message["recipient_username"].get(text) == simdjson::SUCCESS) record.recipientUsername = std::string(text);
+            if (message["timestamp"].get(text) == simdjson::SUCCESS) record.timestamp = std::string(text);
+            if (message["message_text"].get(text) == simdjson::SUCCESS) record.messageText = std::string(text);
+
+            bytes += encodeRecord(record);
+            count++;
+        }
+
+        std::ofstream outFile(logPath, std::ios::binary | std::ios::trunc);
+        if (!outFile.write(bytes.data(), bytes.size()) || !outFile.flush()) {
+            LOG_ERROR("[DM_LOG] Cannot write " << logPath << ", " << jsonPath << " not imported");
+            outFile.close();
+            std::error_code ec;
+            std::filesystem::remove(logPath, ec);
+            return false;
+        }
+        LOG_INFO("[DM_LOG] Imported " << count << " messages from " << jsonPath << " into " << logPath);
+        return true;
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR("[DM_LOG] Error importing " << jsonPath << ": " << e.what());
+        std::error_code ec;
+        std::filesystem::remove(logPath, ec);
+        return false;
+    }
+}
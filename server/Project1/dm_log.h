@@ -0,0 +1,99 @@
+#ifndef DM_LOG_H
+#define DM_LOG_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "persistence.h"
+
+// One persisted direct message
+struct ChatRecord
+{
+    uint64_t messageID = 0;          // Milliseconds since epoch when the message was saved
+    uint32_t senderUserID = 0;
+    uint32_t recipientUserID = 0;
+    std::string senderUsername;
+    std::string recipientUsername;
+    std::string timestamp;           // Local time, "YYYY-MM-DD HH:MM:SS"
+    std::string messageText;
+};
+
+// A window of consecutive records from one conversation
+struct ChatPage
+{
+    std::vector<ChatRecord> records;
+    uint32_t firstSeq = 0;           // Sequence number of records.front(), 0 is the oldest message
+    uint32_t total = 0;              // Number of messages in the whole conversation
+};
+
+// Append-only record log holding one conversation per file (chat_<a>_<b>.log)
+// Each record is [uint32 payload size][uint32 CRC-32 of payload][payload], so a send costs one append
+// and a torn or corrupted tail is detected on read. Appends are written by the attached PersistenceStage.
+// A sparse index (chat_<a>_<b>.idx) stores the file offset of every INDEX_INTERVAL-th record as a uint64,
+// so a page is read by seeking to the nearest checkpoint instead of scanning the whole file.
+// Not thread-safe except for readPage(const PageLocation&); callers serialize all other access
+class DirectMessageLog
+{
+public:
+    // Records between two index checkpoints
+    static const uint32_t INDEX_INTERVAL = 64;
+
+    // Where one page of a conversation lies in its log, taken while access is serialized
+    struct PageLocation
+    {
+        std::string path;
+        uint64_t offset = 0;             // Checkpoint at or before the first record of the page
+        uint32_t offsetSeq = 0;          // Sequence number of the record at offset
+        uint32_t startSeq = 0;           // First record of the page
+        uint32_t endSeq = 0;             // One past the last record of the page
+        uint32_t total = 0;              // Records in the log when the page was located
+    };
+
+    // Sets the persistence stage that performs the appends; must be called before use
+    void setPersistence(PersistenceStage* stage) { persistence = stage; }
+
+    // Queues a record for the conversation between user1 and user2
+    bool append(const std::string& user1, const std::string& user2, const ChatRecord& record,
+        PersistenceStage::DurableCallback onDurable = nullptr);
+
+    // Locates up to limit records with sequence numbers below beforeSeq, i.e. the newest page when
+    // beforeSeq is past the end, and the page just older than a previous one when it is that page's firstSeq
+    PageLocation locatePage(const std::string& user1, const std::string& user2, uint32_t beforeSeq, uint32_t limit);
+
+    // Reads a located page from disk, first writing out appends still queued
+    // Safe to call without serializing: the records of a located page are never rewritten
+    ChatPage readPage(const PageLocation& location) const;
+
+    // Number of records in the conversation's log
+    uint32_t messageCount(const std::string& user1, const std::string& user2);
+
+    // Log file name for the conversation between two users (independent of argument order)
+    static std::string fileName(const std::string& user1, const std::string& user2);
+
+private:
+    // In-memory view of one log, kept current by append
+    struct LogState
+    {
+        uint64_t size = 0;                   // Bytes in the log, including appends still queued
+        uint32_t count = 0;                  // Records in the log
+        std::vector<uint64_t> checkpoints;   // checkpoints[i] = offset of record i * INDEX_INTERVAL
+    };
+
+    // On first use of a log: imports the legacy chat_<a>_<b>.json file, loads the index and
+    // scans only the records after its last checkpoint, cutting off a torn tail
+    LogState& prepare(const std::string& path);
+
+    // Imports messages from the old JSON conversation file into a new log
+    // Returns false, leaving the JSON file untouched and no log behind, if it cannot be imported
+    bool importLegacyJson(const std::string& jsonPath, const std::string& logPath);
+
+    static std::string indexFileName(const std::string& logPath);
+
+    // Logs opened by this process
+    std::unordered_map<std::string, LogState> logs;
+
+    PersistenceStage* persistence = nullptr;
+};
+
+#endif // DM_LOG_H
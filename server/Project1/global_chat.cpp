@@ -1,17 +1,130 @@
 #include "global_chat.h"
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
 #include <ctime>
 #include <fstream>
-#include <iostream>
+#include <filesystem>
+#include "simdjson.h"
+#include "logger.h"
 
-void GlobalChatManager::saveGlobalMessage(const std::string& senderUsername, uint32_t senderUserID, const std::string& messageText)
+namespace
 {
-    // Thread-safe access to global chat operations
-    std::lock_guard<std::mutex> lock(globalChatMutex);
+    // Escapes a string for use inside a JSON string literal
+    std::string escapeJson(const std::string& text)
+    {
+        std::string out;
+        out.reserve(text.size() + 8);
+        for (char c : text) {
+            switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned char>(c));
+                    out += buf;
+                }
+                else {
+                    out += c;
+                }
+            }
+        }
+        return out;
+    }
+
+    // Builds one NDJSON line for a global message
+    std::string makeGlobalMessageLine(uint64_t messageID, const std::string& senderUsername, uint64_t senderUserID,
+        const std::string& messageText, const std::string& timestamp)
+    {
+        std::string line = "{\"message_id\":" + std::to_string(messageID);
+        line += ",\"sender_username\":\"" + escapeJson(senderUsername) + "\"";
+        line += ",\"sender_user_id\":" + std::to_string(senderUserID);
+        line += ",\"message_text\":\"" + escapeJson(messageText) + "\"";
+        line += ",\"timestamp\":\"" + escapeJson(timestamp) + "\"";
+        line += ",\"message_type\":\"global_message\"}\n";
+        return line;
+    }
+}
+
+GlobalChatManager::GlobalChatManager(size_t historyCapacity)
+    : historyCapacity(std::max<size_t>(1, historyCapacity))
+{
+    recentEntries.reserve(this->historyCapacity);
+}
+
+void GlobalChatManager::pushRecentEntry(std::string entry)
+{
+    if (recentEntries.size() < historyCapacity) {
+        recentEntries.push_back(std::move(entry));
+    }
+    else {
+        recentEntries[recentHead] = std::move(entry);
+        recentHead = (recentHead + 1) % historyCapacity;
+    }
+    encodedHistory.reset();
+}
+
+void GlobalChatManager::convertLegacyGlobalChat()
+{
+    if (legacyChecked)
+        return;
+    legacyChecked = true;
+
+    if (std::filesystem::exists(GLOBAL_CHAT_FILE) || !std::filesystem::exists(LEGACY_GLOBAL_CHAT_FILE))
+        return;
 
     try {
-        const std::string globalChatFile = "global_chat.json";
+        simdjson::dom::parser parser;
+        simdjson::dom::element doc;
+        simdjson::dom::array messages;
+        if (parser.load(LEGACY_GLOBAL_CHAT_FILE).get(doc) != simdjson::SUCCESS ||
+            doc["messages"].get(messages) != simdjson::SUCCESS) {
+            LOG_ERROR("[GLOBAL_CHAT] Cannot parse " << LEGACY_GLOBAL_CHAT_FILE << ", starting a new log");
+            return;
+        }
+
+        std::string lines;
+        size_t count = 0;
+        for (auto message : messages) {
+            uint64_t messageID = 0;
+            uint64_t senderUserID = 0;
+            std::string_view senderUsername;
+            std::string_view messageText;
+            std::string_view timestamp;
+
+            if (message["message_id"].get(messageID) != simdjson::SUCCESS) messageID = 0;
+            if (message["sender_user_id"].get(senderUserID) != simdjson::SUCCESS) senderUserID = 0;
+            if (message["sender_username"].get(senderUsername) != simdjson::SUCCESS ||
+                message["message_text"].get(messageText) != simdjson::SUCCESS) {
+                continue;
+            }
+            if (message["timestamp"].get(timestamp) != simdjson::SUCCESS) {
+                timestamp = "Unknown time";
+            }
 
+            lines += makeGlobalMessageLine(messageID, std::string(senderUsername), senderUserID,
+                std::string(messageText), std::string(timestamp));
+            count++;
+        }
+
+        std::ofstream outFile(GLOBAL_CHAT_FILE, std::ios::binary | std::ios::trunc);
+        outFile << lines;
+        LOG_INFO("[GLOBAL_CHAT] Converted " << count << " messages from " << LEGACY_GLOBAL_CHAT_FILE
+            << " to " << GLOBAL_CHAT_FILE);
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR("[GLOBAL_CHAT] Error converting legacy global chat: " << e.what());
+    }
+}
+
+void GlobalChatManager::saveGlobalMessage(const std::string& senderUsername, uint32_t senderUserID, const std::string& messageText,
+    PersistenceStage::DurableCallback onDurable)
+{
+    try {
         // Get current timestamp for message creation
         auto now = std::chrono::system_clock::now();
         time_t time_now = std::chrono::system_clock::to_time_t(now);
@@ -26,120 +139,97 @@ void GlobalChatManager::saveGlobalMessage(const std::string& senderUsername, uin
         std::strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &timeinfo);
 
         // Generate unique message ID using timestamp in milliseconds
-        auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count();
-
-        // Read existing file content if it exists
-        std::string existingContent;
-        std::ifstream inFile(globalChatFile);
-        bool fileExists = false;
-
-        if (inFile.is_open()) {
-            fileExists = true;
-            std::string line;
-            while (std::getline(inFile, line)) {
-                existingContent += line + "\n";
-            }
-            inFile.close();
-        }
+        auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
 
-        // Create new message in JSON format
-        std::string newMessage = "    {\n";
-        newMessage += "      \"message_id\": " + std::to_string(timestamp) + ",\n";
-        newMessage += "      \"sender_username\": \"" + senderUsername + "\",\n";
-        newMessage += "      \"sender_user_id\": " + std::to_string(senderUserID) + ",\n";
-        newMessage += "      \"message_text\": \"" + messageText + "\",\n";
-        newMessage += "      \"timestamp\": \"" + std::string(timeStr) + "\",\n";
-        newMessage += "      \"message_type\": \"global_message\"\n";
-        newMessage += "    }";
-
-        // Open file for writing
-        std::ofstream outFile(globalChatFile);
-        if (outFile.is_open()) {
-            if (!fileExists || existingContent.empty() || existingContent.find("\"messages\"") == std::string::npos) {
-                // Create new chat file structure
-                outFile << "{\n";
-                outFile << "  \"chat_type\": \"global_chat\",\n";
-                outFile << "  \"created_date\": \"" + std::string(timeStr) + "\",\n";
-                outFile << "  \"messages\": [\n";
-                outFile << newMessage << "\n";
-                outFile << "  ]\n";
-                outFile << "}\n";
-
-                std::cout << "[GLOBAL_CHAT] Created new global chat file\n";
-            }
-            else {
-                // Append message to existing file
-                size_t insertPos = existingContent.rfind("  ]\n}");
-                if (insertPos != std::string::npos) {
-                    // Check if there are already messages in the array
-                    size_t lastObjectPos = existingContent.rfind("    }", insertPos);
-                    if (lastObjectPos != std::string::npos) {
-                        // Add comma separator before new message
-                        existingContent.insert(insertPos, ",\n" + newMessage + "\n");
-                    }
-                    else {
-                        // First message in the array
-                        existingContent.insert(insertPos, newMessage + "\n");
-                    }
-                }
-                else {
-                    // File structure is corrupted, recreate it
-                    existingContent = "{\n";
-                    existingContent += "  \"chat_type\": \"global_chat\",\n";
-                    existingContent += "  \"created_date\": \"" + std::string(timeStr) + "\",\n";
-                    existingContent += "  \"messages\": [\n" + newMessage + "\n  ]\n}\n";
-                }
+        // Build the log line and history entry outside the lock; only the append itself is serialized
+        std::string line = makeGlobalMessageLine(timestamp, senderUsername, senderUserID, messageText, timeStr);
+        std::string historyEntry;
+        appendHistoryEntry(historyEntry, timestamp, senderUserID, messageText);
 
-                outFile << existingContent;
-            }
+        // Thread-safe access to global chat operations
+        std::lock_guard<std::mutex> lock(globalChatMutex);
+
+        convertLegacyGlobalChat();
+        pushRecentEntry(std::move(historyEntry));
 
-            outFile.close();
-            std::cout << "[GLOBAL_CHAT] Global message saved with ID=" << timestamp << "\n";
+        if (persistence) {
+            // Queued as a single append, earlier lines are never touched
+            persistence->append(GLOBAL_CHAT_FILE, std::move(line), std::move(onDurable));
+            LOG_DEBUG("[GLOBAL_CHAT] Global message queued with ID=" << timestamp);
         }
         else {
-            std::cerr << "[GLOBAL_CHAT] Failed to open global chat file for writing\n";
+            LOG_ERROR("[GLOBAL_CHAT] No persistence stage attached, global message not saved");
         }
-
     }
     catch (const std::exception& e) {
-        std::cerr << "[GLOBAL_CHAT] Error saving global message: " << e.what() << "\n";
+        LOG_ERROR("[GLOBAL_CHAT] Error saving global message: " << e.what());
     }
 }
 
-std::string GlobalChatManager::loadGlobalChatHistory()
+void GlobalChatManager::loadRecentGlobalMessages()
 {
     // Thread-safe access to global chat operations
     std::lock_guard<std::mutex> lock(globalChatMutex);
+    convertLegacyGlobalChat();
 
     try {
-        const std::string globalChatFile = "global_chat.json";
-        std::ifstream inFile(globalChatFile);
-
-        if (!inFile.is_open()) {
-            std::cout << "[GLOBAL_CHAT] Global chat file not found, returning empty history\n";
-            return "[]"; // Return empty JSON array
+        simdjson::padded_string content;
+        if (simdjson::padded_string::load(GLOBAL_CHAT_FILE).get(content) != simdjson::SUCCESS) {
+            LOG_INFO("[GLOBAL_CHAT] Global chat file not found, starting with empty history");
+            return;
         }
 
-        // Read entire file content
-        std::string content;
-        std::string line;
-        while (std::getline(inFile, line)) {
-            content += line + "\n";
+        // Stream through the log one document at a time; the ring keeps only the newest lines
+        simdjson::ondemand::parser parser;
+        simdjson::ondemand::document_stream messages;
+        if (parser.iterate_many(content).get(messages) != simdjson::SUCCESS) {
+            LOG_ERROR("[GLOBAL_CHAT] Cannot read " << GLOBAL_CHAT_FILE);
+            return;
         }
-        inFile.close();
 
-        if (content.empty()) {
-            std::cout << "[GLOBAL_CHAT] Global chat file is empty\n";
-            return "[]";
-        }
+        size_t count = 0;
+        std::string entry;
+        for (auto document : messages) {
+            simdjson::ondemand::object message;
+            uint64_t messageID = 0;
+            uint64_t senderUserID = 0;
+            std::string_view messageText;
+
+            if (document.get_object().get(message) != simdjson::SUCCESS ||
+                message["message_text"].get_string().get(messageText) != simdjson::SUCCESS) {
+                LOG_ERROR("[GLOBAL_CHAT] Skipping malformed line in " << GLOBAL_CHAT_FILE);
+                continue;
+            }
+            if (message["message_id"].get_uint64().get(messageID) != simdjson::SUCCESS) messageID = 0;
+            if (message["sender_user_id"].get_uint64().get(senderUserID) != simdjson::SUCCESS) senderUserID = 0;
 
-        std::cout << "[GLOBAL_CHAT] Global chat history loaded successfully\n";
-        return content;
+            entry.clear();
+            appendHistoryEntry(entry, messageID, static_cast<uint32_t>(senderUserID), messageText);
+            pushRecentEntry(entry);
+            count++;
+        }
 
+        LOG_INFO("[GLOBAL_CHAT] Loaded " << recentEntries.size() << " of " << count
+            << " global messages into the history ring");
     }
     catch (const std::exception& e) {
-        std::cerr << "[GLOBAL_CHAT] Error loading global chat history: " << e.what() << "\n";
-        return "[]";
+        LOG_ERROR("[GLOBAL_CHAT] Error loading global chat history: " << e.what());
+    }
+}
+
+std::shared_ptr<const std::string> GlobalChatManager::recentGlobalHistory()
+{
+    // Thread-safe access to global chat operations
+    std::lock_guard<std::mutex> lock(globalChatMutex);
+
+    if (!encodedHistory) {
+        std::string body;
+        uint32_t count = static_cast<uint32_t>(recentEntries.size());
+        body.append(reinterpret_cast<const char*>(&count), sizeof(count));
+        for (size_t i = 0; i < recentEntries.size(); i++) {
+            body += recentEntries[(recentHead + i) % recentEntries.size()];
+        }
+        encodedHistory = std::make_shared<const std::string>(std::move(body));
     }
-}
\ No newline at end of file
+    return encodedHistory;
+}
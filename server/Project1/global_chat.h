@@ -2,9 +2,13 @@
 #define GLOBAL_CHAT_H
 
 #include <string>
+#include <vector>
+#include <memory>
 #include <mutex>
 #include "net_common.h"
 #include "net_message.h"
+#include "persistence.h"
+#include "history_encoding.h"
 
 class GlobalChatManager
 {
@@ -12,12 +16,53 @@ private:
     // Mutex for thread-safe access to global chat operations
     std::mutex globalChatMutex;
 
+    // Stage that performs the appends to the NDJSON log
+    PersistenceStage* persistence = nullptr;
+
+    // Set once the legacy global_chat.json has been checked for conversion
+    bool legacyChecked = false;
+
+    // Ring of the most recent messages as encoded history entries (guarded by globalChatMutex)
+    std::vector<std::string> recentEntries;
+    size_t recentHead = 0;                          // Index of the oldest entry once the ring is full
+    const size_t historyCapacity;                   // Maximum number of entries in the ring
+
+    // Response body built from the ring, shared until the next message (guarded by globalChatMutex)
+    std::shared_ptr<const std::string> encodedHistory;
+
+    // Adds an encoded entry to the ring, overwriting the oldest one when full. Caller must hold globalChatMutex
+    void pushRecentEntry(std::string entry);
+
+    // Converts the legacy single-document global_chat.json into NDJSON if no NDJSON log exists yet
+    // Caller must hold globalChatMutex
+    void convertLegacyGlobalChat();
+
 public:
+    // Number of recent messages kept in memory when no other capacity is given
+    static const size_t DEFAULT_HISTORY_CAPACITY = 200;
+
+    explicit GlobalChatManager(size_t historyCapacity = DEFAULT_HISTORY_CAPACITY);
+
+    // Newline-delimited JSON log, one message object per line
+    static constexpr const char* GLOBAL_CHAT_FILE = "global_chat.ndjson";
+
+    // Legacy single-document file, read once by the converter
+    static constexpr const char* LEGACY_GLOBAL_CHAT_FILE = "global_chat.json";
+
+    // Sets the persistence stage used for saving messages; must be called before use
+    void setPersistence(PersistenceStage* stage) { persistence = stage; }
+
     // Method for saving global chat messages to persistent storage
-    void saveGlobalMessage(const std::string& senderUsername, uint32_t senderUserID, const std::string& messageText);
+    // onDurable is called from the persistence thread once the message is on disk
+    void saveGlobalMessage(const std::string& senderUsername, uint32_t senderUserID, const std::string& messageText,
+        PersistenceStage::DurableCallback onDurable = nullptr);
+
+    // Fills the recent-message ring from the NDJSON log; called once at startup
+    void loadRecentGlobalMessages();
 
-    // Method for loading and retrieving global chat history from storage
-    std::string loadGlobalChatHistory();
+    // Returns the recent global chat history as a GlobalChatHistoryResponse body ([uint32 count][entries]),
+    // served from memory. The same string is returned until the next message is saved
+    std::shared_ptr<const std::string> recentGlobalHistory();
 };
 
-#endif // GLOBAL_CHAT_H
\ No newline at end of file
+#endif // GLOBAL_CHAT_H
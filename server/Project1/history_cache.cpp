@@ -0,0 +1,130 @@
+#include "history_cache.h"
+#include <algorithm>
+
+namespace
+{
+    // Memory charged for one cached message
+    size_t messageCost(const std::string& message)
+    {
+        return sizeof(std::string) + message.size();
+    }
+}
+
+HistoryCache::HistoryCache(size_t maxBytes, uint32_t maxMessagesPerConversation)
+    : maxBytes(maxBytes), maxMessages(std::max<uint32_t>(1, maxMessagesPerConversation))
+{
+}
+
+bool HistoryCache::find(const std::string& conversation, uint32_t beforeSeq, uint32_t limit, HistoryPage& page)
+{
+    auto it = entries.find(conversation);
+    if (it == entries.end())
+        return false;
+
+    Entry& entry = it->second;
+    uint32_t total = entry.firstSeq + static_cast<uint32_t>(entry.messages.size());
+    uint32_t endSeq = std::min(beforeSeq, total);
+    uint32_t startSeq = endSeq > limit ? endSeq - limit : 0;
+    if (startSeq < entry.firstSeq)
+        return false;
+
+    page.entries.clear();
+    for (uint32_t seq = startSeq; seq < endSeq; seq++)
+        page.entries += entry.messages[seq - entry.firstSeq];
+
+    page.firstSeq = startSeq;
+    page.count = endSeq - startSeq;
+    page.total = total;
+
+    touch(entry);
+    return true;
+}
+
+void HistoryCache::addPage(const std::string& conversation, uint32_t firstSeq, uint32_t total, std::vector<std::string> messages)
+{
+    uint32_t endSeq = firstSeq + static_cast<uint32_t>(messages.size());
+
+    auto it = entries.find(conversation);
+    if (it != entries.end()) {
+        Entry& entry = it->second;
+        uint32_t cachedTotal = entry.firstSeq + static_cast<uint32_t>(entry.messages.size());
+
+        if (cachedTotal == total) {
+            // Extend the window backwards with the part of an older page that reaches its start
+            if (firstSeq < entry.firstSeq && endSeq >= entry.firstSeq) {
+                for (uint32_t i = entry.firstSeq - firstSeq; i-- > 0 && entry.messages.size() < maxMessages;) {
+                    entry.bytes += messageCost(messages[i]);
+                    cachedBytes += messageCost(messages[i]);
+                    entry.messages.push_front(std::move(messages[i]));
+                    entry.firstSeq--;
+                }
+            }
+            touch(entry);
+            evict();
+            return;
+        }
+
+        // Out of step with the log, start over from this page
+        cachedBytes -= entry.bytes;
+        lru.erase(entry.lruPos);
+        entries.erase(it);
+    }
+
+    // Only a page ending at the newest message can start a window
+    if (endSeq != total)
+        return;
+
+    lru.push_front(conversation);
+    Entry& entry = entries[conversation];
+    entry.lruPos = lru.begin();
+    entry.firstSeq = firstSeq;
+    for (std::string& message : messages) {
+        entry.bytes += messageCost(message);
+        entry.messages.push_back(std::move(message));
+    }
+    cachedBytes += entry.bytes;
+
+    trim(entry);
+    evict();
+}
+
+void HistoryCache::append(const std::string& conversation, std::string message)
+{
+    auto it = entries.find(conversation);
+    if (it == entries.end())
+        return;
+
+    Entry& entry = it->second;
+    entry.bytes += messageCost(message);
+    cachedBytes += messageCost(message);
+    entry.messages.push_back(std::move(message));
+
+    trim(entry);
+    touch(entry);
+    evict();
+}
+
+void HistoryCache::touch(Entry& entry)
+{
+    lru.splice(lru.begin(), lru, entry.lruPos);
+}
+
+void HistoryCache::trim(Entry& entry)
+{
+    while (entry.messages.size() > maxMessages) {
+        entry.bytes -= messageCost(entry.messages.front());
+        cachedBytes -= messageCost(entry.messages.front());
+        entry.messages.pop_front();
+        entry.firstSeq++;
+    }
+}
+
+void HistoryCache::evict()
+{
+    while (cachedBytes > maxBytes && !lru.empty()) {
+        auto it = entries.find(lru.back());
+        cachedBytes -= it->second.bytes;
+        entries.erase(it);
+        lru.pop_back();
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef HISTORY_CACHE_H
+#define HISTORY_CACHE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <cstdint>
+
+// A page of encoded history served from the cache
+struct HistoryPage
+{
+    std::string entries;             // Encoded history entries of the page, oldest first
+    uint32_t firstSeq = 0;           // Sequence number of the first entry
+    uint32_t count = 0;              // Entries in the page
+    uint32_t total = 0;              // Messages in the whole conversation
+};
+
+// Memory-budgeted LRU cache of encoded conversation histories, keyed by conversation id
+// Each entry holds the encoded history entries of the newest messages of one conversation, i.e. the window
+// [firstSeq, total). New messages extend the window instead of invalidating it, and older pages read
+// from disk are prepended when they reach the start of the window.
+// Not thread-safe; callers serialize access
+class HistoryCache
+{
+public:
+    explicit HistoryCache(size_t maxBytes = 16 * 1024 * 1024, uint32_t maxMessagesPerConversation = 1000);
+
+    // Fills page with up to limit messages below beforeSeq if the cached window holds all of them
+    bool find(const std::string& conversation, uint32_t beforeSeq, uint32_t limit, HistoryPage& page);
+
+    // Stores a page just read from disk; ignored unless it ends at the newest message or reaches
+    // back from the start of the cached window
+    void addPage(const std::string& conversation, uint32_t firstSeq, uint32_t total, std::vector<std::string> messages);
+
+    // Extends the cached window by a newly appended message; conversations not cached are left alone
+    void append(const std::string& conversation, std::string message);
+
+    size_t bytes() const { return cachedBytes; }
+
+private:
+    struct Entry
+    {
+        std::deque<std::string> messages;        // One encoded entry per message, back() is the newest
+        uint32_t firstSeq = 0;
+        size_t bytes = 0;
+        std::list<std::string>::iterator lruPos;
+    };
+
+    // Marks an entry as most recently used
+    void touch(Entry& entry);
+
+    // Drops the oldest messages of an entry beyond the per-conversation limit
+    void trim(Entry& entry);
+
+    // Evicts least recently used conversations until the cache fits its budget
+    void evict();
+
+    size_t maxBytes;
+    uint32_t maxMessages;
+    size_t cachedBytes = 0;
+
+    std::unordered_map<std::string, Entry> entries;
+    std::list<std::string> lru;                  // Front is the most recently used conversation
+};
+
+#endif // HISTORY_CACHE_H
@@ -0,0 +1,33 @@
+#ifndef HISTORY_ENCODING_H
+#define HISTORY_ENCODING_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+
+// Binary history entries carried by ChatHistoryResponse and GlobalChatHistoryResponse:
+//   [uint64 message ID][uint32 sender user ID][uint32 send time, seconds since epoch][uint32 text length][text]
+// The client formats the time and the banners itself.
+// Message IDs are the send time in milliseconds, so the timestamp is derived from the ID without any clock calls.
+inline void appendHistoryEntry(std::string& out, uint64_t messageID, uint32_t senderUserID, std::string_view text)
+{
+    uint32_t timestamp = static_cast<uint32_t>(messageID / 1000);
+    uint32_t length = static_cast<uint32_t>(text.size());
+
+    out.append(reinterpret_cast<const char*>(&messageID), sizeof(messageID));
+    out.append(reinterpret_cast<const char*>(&senderUserID), sizeof(senderUserID));
+    out.append(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+    out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.append(text);
+}
+
+// Returns the offset just past the entry that starts at offset in a block of encoded entries
+inline size_t nextHistoryEntry(std::string_view entries, size_t offset)
+{
+    uint32_t length = 0;
+    std::memcpy(&length, entries.data() + offset + sizeof(uint64_t) + 2 * sizeof(uint32_t), sizeof(length));
+    return offset + sizeof(uint64_t) + 3 * sizeof(uint32_t) + length;
+}
+
+#endif // HISTORY_ENCODING_H
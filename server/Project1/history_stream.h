@@ -0,0 +1,190 @@
+#ifndef HISTORY_STREAM_H
+#define HISTORY_STREAM_H
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "net_server.h"
+#include "history_encoding.h"
+
+// Streams large history responses as HistoryChunk frames with credit-based flow control
+// A stream keeps at most HISTORY_CHUNK_WINDOW chunks unacknowledged; every HistoryChunkAck releases the next one,
+// so other messages to the client are queued between chunks instead of behind the whole history.
+// Chunks end on entry boundaries and each carries a complete response body, so the client can render it on arrival.
+// Chunks beyond the window wait here rather than in the connection's outgoing queue, so their memory is bounded
+// separately: a client has at most MAX_STREAMS_PER_CLIENT open streams and all streams together hold at most
+// MAX_PENDING_BYTES of unsent chunks.
+class HistoryStreamer
+{
+public:
+    using Connection = std::shared_ptr<olc::net::connection<CustomMsgTypes>>;
+
+    // Open streams per client; a new stream cancels the client's oldest one beyond this
+    static const size_t MAX_STREAMS_PER_CLIENT = 2;
+
+    // Unsent chunks of all streams together; a stream that would exceed it is refused
+    static const size_t MAX_PENDING_BYTES = 64 * 1024 * 1024;
+
+    // Splits entries into chunks and sends the first window
+    // header is the response body in front of the entry count (e.g. partner ID, cursor and total for chat history)
+    // Returns false, sending nothing, if the unsent chunks would not fit into MAX_PENDING_BYTES
+    // Sends nothing to a client already removed from the server, whose streams drop() may have forgotten already
+    bool send(const Connection& client, CustomMsgTypes responseType, const std::string& header, std::string_view entries)
+    {
+        // Cut the entries into ranges of about HISTORY_CHUNK_SIZE bytes, at least one entry each
+        struct Range { size_t begin; size_t end; uint32_t count; };
+        std::vector<Range> ranges;
+        Range current{ 0, 0, 0 };
+        while (current.end < entries.size()) {
+            size_t next = nextHistoryEntry(entries, current.end);
+            if (current.count > 0 && next - current.begin > HISTORY_CHUNK_SIZE) {
+                ranges.push_back(current);
+                current = Range{ current.end, current.end, 0 };
+            }
+            current.end = next;
+            current.count++;
+        }
+        ranges.push_back(current);
+
+        Stream stream;
+        uint32_t streamID = 0;
+        {
+            std::lock_guard<std::mutex> lock(muxStreams);
+            streamID = nextStreamID++;
+        }
+
+        uint32_t chunkCount = static_cast<uint32_t>(ranges.size());
+        for (uint32_t i = 0; i < chunkCount; i++) {
+            olc::net::message<CustomMsgTypes> chunk;
+            chunk.header.id = CustomMsgTypes::HistoryChunk;
+            chunk << streamID;
+            chunk << static_cast<uint32_t>(responseType);
+            chunk << i;
+            chunk << chunkCount;
+
+            // A complete response body holding only this chunk's entries
+            chunk.writeBytes(header.data(), header.size());
+            chunk << ranges[i].count;
+            chunk.writeBytes(entries.data() + ranges[i].begin, ranges[i].end - ranges[i].begin);
+
+            stream.pending.push_back(olc::net::make_shared_frame(chunk));
+            stream.bytes += stream.pending.back()->size();
+        }
+
+        std::vector<olc::net::shared_frame<CustomMsgTypes>> ready;
+        {
+            std::lock_guard<std::mutex> lock(muxStreams);
+
+            // The server marks a client removed before calling drop(), which takes muxStreams:
+            // a stream registered here while the client still counts as connected is forgotten by that drop()
+            if (!client->isConnected())
+                return true;
+
+            auto& clientStreams = streams[client->getID()];
+
+            // Streams this one replaces, oldest first (stream IDs only grow)
+            size_t nCancelled = clientStreams.size() >= MAX_STREAMS_PER_CLIENT ? clientStreams.size() - MAX_STREAMS_PER_CLIENT + 1 : 0;
+            size_t freedBytes = 0;
+            auto it = clientStreams.begin();
+            for (size_t i = 0; i < nCancelled; i++, ++it)
+                freedBytes += it->second.bytes;
+
+            takeWindow(stream, ready);
+            if (pendingBytes - freedBytes + stream.bytes > MAX_PENDING_BYTES) {
+                if (clientStreams.empty())
+                    streams.erase(client->getID());
+                return false;
+            }
+
+            clientStreams.erase(clientStreams.begin(), it);
+            pendingBytes -= freedBytes;
+            if (!stream.pending.empty()) {
+                pendingBytes += stream.bytes;
+                clientStreams.emplace(streamID, std::move(stream));
+            }
+            if (clientStreams.empty())
+                streams.erase(client->getID());
+        }
+
+        for (auto& frame : ready)
+            client->send(frame);
+        return true;
+    }
+
+    // Releases the next chunk of a stream after the client processed one
+    void acknowledge(const Connection& client, uint32_t streamID)
+    {
+        std::vector<olc::net::shared_frame<CustomMsgTypes>> ready;
+        {
+            std::lock_guard<std::mutex> lock(muxStreams);
+            auto clientStreams = streams.find(client->getID());
+            if (clientStreams == streams.end())
+                return;
+
+            auto it = clientStreams->second.find(streamID);
+            if (it == clientStreams->second.end())
+                return;
+
+            Stream& stream = it->second;
+            if (stream.unacknowledged > 0)
+                stream.unacknowledged--;
+            pendingBytes -= takeWindow(stream, ready);
+
+            if (stream.pending.empty()) {
+                clientStreams->second.erase(it);
+                if (clientStreams->second.empty())
+                    streams.erase(clientStreams);
+            }
+        }
+
+        for (auto& frame : ready)
+            client->send(frame);
+    }
+
+    // Forgets the streams of a disconnected client
+    void drop(uint32_t clientID)
+    {
+        std::lock_guard<std::mutex> lock(muxStreams);
+        auto clientStreams = streams.find(clientID);
+        if (clientStreams == streams.end())
+            return;
+
+        for (const auto& stream : clientStreams->second)
+            pendingBytes -= stream.second.bytes;
+        streams.erase(clientStreams);
+    }
+
+private:
+    struct Stream
+    {
+        std::deque<olc::net::shared_frame<CustomMsgTypes>> pending;   // Chunks not sent yet
+        uint32_t unacknowledged = 0;                                  // Chunks sent but not acknowledged
+        size_t bytes = 0;                                             // Size of the pending chunks
+    };
+
+    // Moves chunks from a stream into ready until its window is full, returns their size. Caller must hold muxStreams
+    static size_t takeWindow(Stream& stream, std::vector<olc::net::shared_frame<CustomMsgTypes>>& ready)
+    {
+        size_t taken = 0;
+        while (!stream.pending.empty() && stream.unacknowledged < HISTORY_CHUNK_WINDOW) {
+            taken += stream.pending.front()->size();
+            ready.push_back(std::move(stream.pending.front()));
+            stream.pending.pop_front();
+            stream.unacknowledged++;
+        }
+        stream.bytes -= taken;
+        return taken;
+    }
+
+    std::mutex muxStreams;
+    std::unordered_map<uint32_t, std::map<uint32_t, Stream>> streams;  // Client ID -> stream ID -> stream, oldest first
+    size_t pendingBytes = 0;                                            // Sum of the streams' pending bytes
+    uint32_t nextStreamID = 1;
+};
+
+#endif // HISTORY_STREAM_H
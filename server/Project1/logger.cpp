@@ -0,0 +1,136 @@
+#include "logger.h"
+#include <cstdio>
+
+Logger& Logger::instance()
+{
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger()
+    : ring(new Slot[RING_SIZE])
+{
+    for (size_t i = 0; i < RING_SIZE; i++)
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+
+    thread = std::thread([this]() { run(); });
+}
+
+Logger::~Logger()
+{
+    stopping.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(muxWake);
+        cvWake.notify_one();
+    }
+    if (thread.joinable())
+        thread.join();
+}
+
+void Logger::write(LogLevel level, std::string line)
+{
+    if (!tryPush(level, line)) {
+        // A full ring is never empty, so the logger thread is already awake or about to be woken
+        droppedLines.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Wake the logger thread only if it is parked (pairs with the fence in run())
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(muxWake);
+        cvWake.notify_one();
+    }
+}
+
+bool Logger::tryPush(LogLevel level, std::string& line)
+{
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    while (true) {
+        Slot& slot = ring[pos & (RING_SIZE - 1)];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+        if (diff == 0) {
+            // The slot is free for this position, claim it
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.level = level;
+                slot.line = std::move(line);
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0) {
+            return false; // Full, the logger thread has not caught up
+        }
+        else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool Logger::tryPop(LogLevel& level, std::string& line)
+{
+    Slot& slot = ring[dequeuePos & (RING_SIZE - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != dequeuePos + 1)
+        return false;
+
+    level = slot.level;
+    line = std::move(slot.line);
+    slot.line.clear();
+    slot.sequence.store(dequeuePos + RING_SIZE, std::memory_order_release);
+    dequeuePos++;
+    return true;
+}
+
+bool Logger::pending() const
+{
+    return ring[dequeuePos & (RING_SIZE - 1)].sequence.load(std::memory_order_acquire) == dequeuePos + 1;
+}
+
+void Logger::run()
+{
+    std::string out;
+    std::string err;
+    LogLevel level;
+    std::string line;
+
+    while (true) {
+        bool stop = stopping.load(std::memory_order_acquire);
+
+        // Gather everything queued into one write per stream
+        while (tryPop(level, line)) {
+            std::string& target = level >= LogLevel::Warn ? err : out;
+            target += line;
+            target += '\n';
+        }
+
+        uint64_t dropped = droppedLines.load(std::memory_order_relaxed);
+        if (dropped != reportedDropped) {
+            err += "[LOG] " + std::to_string(dropped - reportedDropped) + " log line(s) dropped, log ring full\n";
+            reportedDropped = dropped;
+        }
+
+        if (!out.empty()) {
+            std::fwrite(out.data(), 1, out.size(), stdout);
+            std::fflush(stdout);
+            out.clear();
+        }
+        if (!err.empty()) {
+            std::fwrite(err.data(), 1, err.size(), stderr);
+            std::fflush(stderr);
+            err.clear();
+        }
+
+        if (stop)
+            return;
+
+        // Announce the intent to sleep before the final check, so a concurrent write either sees
+        // the flag or its line is seen here
+        std::unique_lock<std::mutex> lock(muxWake);
+        parked.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cvWake.wait(lock, [this]() { return stopping.load(std::memory_order_acquire) || pending(); });
+        parked.store(false, std::memory_order_relaxed);
+    }
+}
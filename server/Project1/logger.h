@@ -0,0 +1,100 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+enum class LogLevel : int {
+    Debug = 0,      // Per-message tracing
+    Info = 1,       // Lifecycle events: connections, logins, startup
+    Warn = 2,       // Recoverable problems
+    Error = 3,      // Failures
+    Off = 4
+};
+
+// Messages below this level are compiled out entirely (define it in the project to raise it)
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 0
+#endif
+
+// Asynchronous logger: callers format a line and push it into a lock-free ring buffer; a background
+// thread drains the ring and writes whole batches to stdout (Debug/Info) or stderr (Warn/Error).
+// Logging never blocks the caller: when the ring is full the line is dropped and counted.
+// The thread sleeps while the ring is empty; a caller only touches the wakeup mutex when it is asleep.
+class Logger
+{
+public:
+    static Logger& instance();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    // Writes everything still queued, then stops the thread
+    ~Logger();
+
+    // Lines below the runtime level are discarded before they are formatted
+    void setLevel(LogLevel level) { minLevel.store(static_cast<int>(level), std::memory_order_relaxed); }
+    LogLevel level() const { return static_cast<LogLevel>(minLevel.load(std::memory_order_relaxed)); }
+    bool enabled(LogLevel level) const { return static_cast<int>(level) >= minLevel.load(std::memory_order_relaxed); }
+
+    // Queues one line (without trailing newline)
+    void write(LogLevel level, std::string line);
+
+    // Lines lost because the ring was full
+    uint64_t dropped() const { return droppedLines.load(std::memory_order_relaxed); }
+
+private:
+    Logger();
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogLevel level = LogLevel::Info;
+        std::string line;
+    };
+
+    // Bounded multi-producer ring (one sequence number per slot); only the logger thread pops
+    bool tryPush(LogLevel level, std::string& line);
+    bool tryPop(LogLevel& level, std::string& line);
+    bool pending() const;
+
+    void run();
+
+    static constexpr size_t RING_SIZE = 8192;   // Power of two
+    std::unique_ptr<Slot[]> ring;
+    alignas(64) std::atomic<size_t> enqueuePos{ 0 };
+    alignas(64) size_t dequeuePos = 0;
+
+    std::atomic<int> minLevel{ static_cast<int>(LogLevel::Info) };
+    std::atomic<uint64_t> droppedLines{ 0 };
+    uint64_t reportedDropped = 0;
+
+    alignas(64) std::atomic<bool> parked{ false };
+    std::mutex muxWake;
+    std::condition_variable cvWake;
+    std::atomic<bool> stopping{ false };
+    std::thread thread;
+};
+
+// LOG_INFO("[SERVER] Client " << id << " connected"); the stream expression is only evaluated when enabled
+#define LOG_AT(lvl, expr) \
+    do { \
+        if (static_cast<int>(lvl) >= LOG_COMPILE_LEVEL && Logger::instance().enabled(lvl)) { \
+            std::ostringstream logStream_; \
+            logStream_ << expr; \
+            Logger::instance().write(lvl, logStream_.str()); \
+        } \
+    } while (0)
+
+#define LOG_DEBUG(expr) LOG_AT(LogLevel::Debug, expr)
+#define LOG_INFO(expr)  LOG_AT(LogLevel::Info, expr)
+#define LOG_WARN(expr)  LOG_AT(LogLevel::Warn, expr)
+#define LOG_ERROR(expr) LOG_AT(LogLevel::Error, expr)
+
+#endif // LOGGER_H
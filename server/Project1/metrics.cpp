@@ -0,0 +1,159 @@
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+thread_local Metrics::Shard* Metrics::localShard = nullptr;
+
+Metrics::Histogram::Histogram()
+{
+    for (auto& bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+void Metrics::HistogramSnapshot::add(const Histogram& histogram)
+{
+    if (buckets.empty())
+        buckets.resize(Histogram::BUCKETS, 0);
+
+    for (size_t i = 0; i < Histogram::BUCKETS; i++)
+        buckets[i] += histogram.buckets[i].load(std::memory_order_relaxed);
+    count += histogram.count.load(std::memory_order_relaxed);
+    sum += histogram.sum.load(std::memory_order_relaxed);
+    max = std::max(max, histogram.max.load(std::memory_order_relaxed));
+}
+
+uint64_t Metrics::HistogramSnapshot::percentile(double fraction) const
+{
+    if (count == 0)
+        return 0;
+
+    uint64_t rank = std::max<uint64_t>(1, uint64_t(std::ceil(fraction * double(count))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= rank)
+            return std::min(Histogram::bucketLimit(i), max);
+    }
+    return max;
+}
+
+Metrics& Metrics::instance()
+{
+    static Metrics metrics;
+    return metrics;
+}
+
+Metrics::Metrics()
+    : started(std::chrono::steady_clock::now())
+{
+}
+
+Metrics::Shard::Shard()
+{
+    for (auto& counter : counters)
+        counter.store(0, std::memory_order_relaxed);
+}
+
+Metrics::Shard::~Shard()
+{
+    for (auto& type : types)
+        delete type.handlerTime.load(std::memory_order_relaxed);
+}
+
+Metrics::Shard* Metrics::addShard()
+{
+    std::lock_guard<std::mutex> lock(muxShards);
+    shards.push_back(std::make_unique<Shard>());
+    return shards.back().get();
+}
+
+Metrics::Snapshot Metrics::snapshot() const
+{
+    Snapshot snapshot;
+    snapshot.uptime = std::chrono::steady_clock::now() - started;
+
+    std::lock_guard<std::mutex> lock(muxShards);
+    for (const auto& shard : shards) {
+        for (size_t i = 0; i < MAX_TYPES; i++) {
+            const TypeStats& stats = shard->types[i];
+            TypeSnapshot& type = snapshot.types[i];
+            type.messagesIn += stats.messagesIn.load(std::memory_order_relaxed);
+            type.bytesIn += stats.bytesIn.load(std::memory_order_relaxed);
+            type.messagesOut += stats.messagesOut.load(std::memory_order_relaxed);
+            type.bytesOut += stats.bytesOut.load(std::memory_order_relaxed);
+            if (const Histogram* histogram = stats.handlerTime.load(std::memory_order_acquire))
+                type.handlerTime.add(*histogram);
+        }
+        for (size_t i = 0; i < size_t(CounterId::Count); i++)
+            snapshot.counters[i] += shard->counters[i].load(std::memory_order_relaxed);
+        for (size_t i = 0; i < size_t(HistogramId::Count); i++)
+            snapshot.histograms[i].add(shard->histograms[i]);
+    }
+    return snapshot;
+}
+
+namespace
+{
+    // "p50/p99/max" of a histogram, or "-" when it is empty
+    std::string distribution(const Metrics::HistogramSnapshot& histogram)
+    {
+        if (histogram.count == 0)
+            return "-";
+        return std::to_string(histogram.percentile(0.50)) + "/" + std::to_string(histogram.percentile(0.99)) +
+            "/" + std::to_string(histogram.max);
+    }
+}
+
+std::string Metrics::format(const Snapshot& snapshot, const std::function<std::string(uint32_t)>& typeName)
+{
+    std::ostringstream out;
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(snapshot.uptime).count();
+    out << "Uptime " << seconds << "s\n";
+
+    out << std::left << std::setw(28) << "Message type" << std::right
+        << std::setw(10) << "In" << std::setw(14) << "Bytes in"
+        << std::setw(10) << "Out" << std::setw(14) << "Bytes out"
+        << "  Handler us p50/p99/max\n";
+
+    for (uint32_t i = 0; i < MAX_TYPES; i++) {
+        const TypeSnapshot& type = snapshot.types[i];
+        if (type.messagesIn == 0 && type.messagesOut == 0 && type.handlerTime.count == 0)
+            continue;
+
+        std::string name = i == MAX_TYPES - 1 ? "(other)" : typeName ? typeName(i) : std::to_string(i);
+        out << std::left << std::setw(28) << name << std::right
+            << std::setw(10) << type.messagesIn << std::setw(14) << type.bytesIn
+            << std::setw(10) << type.messagesOut << std::setw(14) << type.bytesOut
+            << "  " << distribution(type.handlerTime) << "\n";
+    }
+
+    out << "Dispatched " << snapshot.counter(CounterId::Dispatched) << " messages, batch p50/p99/max "
+        << distribution(snapshot.histogram(HistogramId::DispatchBatch)) << "\n";
+    out << "Incoming queue depth at enqueue p50/p99/max " << distribution(snapshot.histogram(HistogramId::IncomingDepth)) << " messages\n";
+    out << "Outgoing queue depth at enqueue p50/p99/max " << distribution(snapshot.histogram(HistogramId::OutboundDepth)) << " frames\n";
+    out << "Persistence: " << snapshot.counter(CounterId::PersistenceBatches) << " batches, "
+        << snapshot.counter(CounterId::PersistenceRecords) << " records, "
+        << snapshot.counter(CounterId::PersistenceBytes) << " bytes; write us p50/p99/max "
+        << distribution(snapshot.histogram(HistogramId::PersistenceWrite)) << ", fsync us p50/p99/max "
+        << distribution(snapshot.histogram(HistogramId::PersistenceSync)) << "\n";
+
+    const std::pair<HistogramId, const char*> stages[] = {
+        { HistogramId::TraceReceive, "receive body" },
+        { HistogramId::TraceEnqueue, "enqueue" },
+        { HistogramId::TraceIncomingQueue, "incoming queue" },
+        { HistogramId::TraceDispatch, "dispatch" },
+        { HistogramId::TraceWorkerQueue, "worker queue" },
+        { HistogramId::TraceHandler, "handler" },
+        { HistogramId::TraceWrite, "write replies" },
+        { HistogramId::TraceTotal, "total" },
+    };
+    out << "Latency of " << snapshot.counter(CounterId::TracedMessages) << " sampled messages, us p50/p99/max\n";
+    for (const auto& stage : stages)
+        out << "  " << std::left << std::setw(16) << stage.second << std::right << distribution(snapshot.histogram(stage.first)) << "\n";
+    return out.str();
+}
@@ -0,0 +1,258 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Process-wide counters and histograms for capacity planning
+// Every thread records into its own shard without locks or contended atomics (each shard has a single
+// writer, readers only load); snapshot() sums the shards of all threads that ever recorded something.
+class Metrics
+{
+public:
+    // Message types get their own counters up to this value; higher ones share the last slot
+    static constexpr uint32_t MAX_TYPES = 64;
+
+    // Counters not tied to a message type
+    enum class CounterId : size_t {
+        Dispatched,             // Messages taken from the incoming queue and handed to onMessage
+        PersistenceBatches,     // Group commits written by the persistence thread
+        PersistenceRecords,     // Records appended
+        PersistenceBytes,       // Bytes appended
+        TracedMessages,         // Sampled messages whose stages were timed
+        Count
+    };
+
+    // Histograms not tied to a message type
+    enum class HistogramId : size_t {
+        DispatchBatch,          // Messages drained from the incoming queue per dispatch pass
+        IncomingDepth,          // Messages already in the incoming queue when another one is added
+        OutboundDepth,          // Frames already queued on a connection when another one is added
+        PersistenceWrite,       // Microseconds to write one batch to the chat logs
+        PersistenceSync,        // Microseconds to fsync the files written since the last sync
+        // Stages of sampled messages in microseconds, see olc::net::message_trace
+        TraceReceive,           // Header read to body read complete
+        TraceEnqueue,           // Body read to push into the incoming queue
+        TraceIncomingQueue,     // Waiting in the incoming queue for update()
+        TraceDispatch,          // Inside onMessage (routing to a worker shard)
+        TraceWorkerQueue,       // Waiting in the worker shard's queue
+        TraceHandler,           // Running the handler
+        TraceWrite,             // Handler end to the last resulting frame written to its socket
+        TraceTotal,             // Header read to the end of the last stage reached
+        Count
+    };
+
+    // Log-linear histogram in the style of HdrHistogram: values below SUB_BUCKETS get a bucket each and
+    // every larger power of two is split into SUB_BUCKETS buckets, so a bucket is within 1/16 of its values.
+    // Values above 2^32 - 1 are clamped. Only one thread may record into a histogram
+    class Histogram
+    {
+    public:
+        static constexpr uint32_t SUB_BITS = 4;
+        static constexpr uint32_t SUB_BUCKETS = 1u << SUB_BITS;
+        static constexpr uint32_t VALUE_BITS = 32;
+        static constexpr size_t BUCKETS = (VALUE_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+        Histogram();
+
+        void record(uint64_t value)
+        {
+            if (value > UINT32_MAX)
+                value = UINT32_MAX;
+            bump(buckets[bucketOf(value)], 1);
+            bump(count, 1);
+            bump(sum, value);
+            if (value > max.load(std::memory_order_relaxed))
+                max.store(value, std::memory_order_relaxed);
+        }
+
+        static size_t bucketOf(uint64_t value)
+        {
+            if (value < SUB_BUCKETS)
+                return size_t(value);
+            uint32_t shift = highestBit(value) - SUB_BITS;
+            return size_t(shift + 1) * SUB_BUCKETS + size_t(value >> shift) - SUB_BUCKETS;
+        }
+
+        // Largest value that falls into a bucket
+        static uint64_t bucketLimit(size_t bucket)
+        {
+            if (bucket < SUB_BUCKETS)
+                return bucket;
+            uint32_t shift = uint32_t(bucket / SUB_BUCKETS) - 1;
+            return ((uint64_t(SUB_BUCKETS + bucket % SUB_BUCKETS) + 1) << shift) - 1;
+        }
+
+    private:
+        friend class Metrics;
+
+        static uint32_t highestBit(uint64_t value)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return uint32_t(index);
+#else
+            return 63 - uint32_t(__builtin_clzll(value));
+#endif
+        }
+
+        std::atomic<uint64_t> buckets[BUCKETS];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> max;
+    };
+
+    // Sum of histograms read at one point in time
+    struct HistogramSnapshot {
+        std::vector<uint64_t> buckets;
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+
+        void add(const Histogram& histogram);
+
+        // Upper bound of the bucket holding the given fraction (0..1) of the values, never above max
+        uint64_t percentile(double fraction) const;
+        uint64_t mean() const { return count ? sum / count : 0; }
+    };
+
+    struct TypeSnapshot {
+        uint64_t messagesIn = 0;
+        uint64_t bytesIn = 0;
+        uint64_t messagesOut = 0;
+        uint64_t bytesOut = 0;
+        HistogramSnapshot handlerTime;  // Microseconds
+    };
+
+    struct Snapshot {
+        std::chrono::steady_clock::duration uptime{};
+        std::array<TypeSnapshot, MAX_TYPES> types;
+        std::array<uint64_t, size_t(CounterId::Count)> counters{};
+        std::array<HistogramSnapshot, size_t(HistogramId::Count)> histograms;
+
+        uint64_t counter(CounterId id) const { return counters[size_t(id)]; }
+        const HistogramSnapshot& histogram(HistogramId id) const { return histograms[size_t(id)]; }
+    };
+
+    static Metrics& instance();
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    // A complete frame of this type (header + body) was received
+    void messageIn(uint32_t type, size_t bytes)
+    {
+        TypeStats& stats = local().types[typeIndex(type)];
+        bump(stats.messagesIn, 1);
+        bump(stats.bytesIn, bytes);
+    }
+
+    // A frame of this type was written to a socket
+    void messageOut(uint32_t type, size_t bytes)
+    {
+        TypeStats& stats = local().types[typeIndex(type)];
+        bump(stats.messagesOut, 1);
+        bump(stats.bytesOut, bytes);
+    }
+
+    // A handler for this type ran for the given time
+    void handlerTime(uint32_t type, std::chrono::steady_clock::duration elapsed)
+    {
+        TypeStats& stats = local().types[typeIndex(type)];
+        Histogram* histogram = stats.handlerTime.load(std::memory_order_acquire);
+        if (!histogram) {
+            // Only types that are actually handled pay for a histogram
+            histogram = new Histogram();
+            stats.handlerTime.store(histogram, std::memory_order_release);
+        }
+        histogram->record(micros(elapsed));
+    }
+
+    void count(CounterId id, uint64_t n = 1)
+    {
+        bump(local().counters[size_t(id)], n);
+    }
+
+    void record(HistogramId id, uint64_t value)
+    {
+        local().histograms[size_t(id)].record(value);
+    }
+
+    void record(HistogramId id, std::chrono::steady_clock::duration elapsed)
+    {
+        record(id, micros(elapsed));
+    }
+
+    // Sums every thread's shard
+    Snapshot snapshot() const;
+
+    // Human-readable table of a snapshot; typeName labels the message types
+    static std::string format(const Snapshot& snapshot, const std::function<std::string(uint32_t)>& typeName);
+
+private:
+    Metrics();
+
+    struct TypeStats {
+        std::atomic<uint64_t> messagesIn{ 0 };
+        std::atomic<uint64_t> bytesIn{ 0 };
+        std::atomic<uint64_t> messagesOut{ 0 };
+        std::atomic<uint64_t> bytesOut{ 0 };
+        std::atomic<Histogram*> handlerTime{ nullptr };   // Allocated on first use by the owning thread
+    };
+
+    // One thread's counters; shards outlive their threads so nothing recorded is lost
+    struct Shard {
+        Shard();
+        ~Shard();
+
+        std::array<TypeStats, MAX_TYPES> types;
+        std::array<std::atomic<uint64_t>, size_t(CounterId::Count)> counters;
+        std::array<Histogram, size_t(HistogramId::Count)> histograms;
+    };
+
+    // Single-writer increment: a plain load and store, no read-modify-write instruction
+    static void bump(std::atomic<uint64_t>& counter, uint64_t n)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static size_t typeIndex(uint32_t type)
+    {
+        return type < MAX_TYPES ? type : MAX_TYPES - 1;
+    }
+
+    static uint64_t micros(std::chrono::steady_clock::duration elapsed)
+    {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        return us > 0 ? uint64_t(us) : 0;
+    }
+
+    Shard& local()
+    {
+        if (!localShard)
+            localShard = addShard();
+        return *localShard;
+    }
+
+    Shard* addShard();
+
+    static thread_local Shard* localShard;
+
+    std::chrono::steady_clock::time_point started;
+    mutable std::mutex muxShards;
+    std::vector<std::unique_ptr<Shard>> shards;
+};
+
+#endif // METRICS_H
@@ -1,5 +1,6 @@
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <deque>
 #include <optional>
 #include <vector>
@@ -7,6 +8,10 @@
 #include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
 
 #ifdef _WIN32
 #define _WIN32_WINNT 0x0A00
@@ -17,3 +22,6 @@
 #include <boost/asio/ts/buffer.hpp>
 #include <boost/asio/ts/internet.hpp>
 
+#include "logger.h"
+#include "metrics.h"
+
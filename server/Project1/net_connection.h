@@ -1,6 +1,6 @@
 #pragma once
 #include "net_common.h"
-#include "net_tsQueue.h"
+#include "net_mpscQueue.h"
 #include "net_message.h"
 
 namespace olc
@@ -10,6 +10,89 @@ namespace olc
         template<typename T>
         class server_interface;
 
+        // What a connection does with new frames while its outgoing queue is above the high watermark
+        enum class slow_consumer_policy
+        {
+            drop_ephemeral,     // Discard ephemeral frames
+            collapse_ephemeral, // Replace a queued ephemeral frame with the same collapse key by the newer one
+            disconnect          // Close the connection
+        };
+
+        // Byte limits on the frames queued or being written on one connection
+        // A connection becomes congested above highWatermark and recovers once it drained to lowWatermark.
+        // maxQueuedBytes bounds reliable frames as well: beyond it the connection is closed under any policy.
+        struct outbound_limits
+        {
+            size_t highWatermark = 256 * 1024;
+            size_t lowWatermark = 64 * 1024;
+            size_t maxQueuedBytes = 4 * 1024 * 1024;
+            slow_consumer_policy policy = slow_consumer_policy::collapse_ephemeral;
+        };
+
+        // Largest frame (header + body) accepted per message type, checked before any body is buffered
+        struct inbound_limits
+        {
+            std::vector<uint32_t> maxFrameSize;     // Indexed by message type
+            uint32_t defaultMaxFrameSize = 256;     // Types without an entry
+        };
+
+        // Server-wide budget for received bytes: receive buffers plus parsed messages not yet handled
+        // Connections stop reading while it is exhausted and resume once handlers have released memory
+        struct inbound_budget
+        {
+            size_t capacity = 64 * 1024 * 1024;
+            std::atomic<size_t> used{ 0 };
+
+            std::atomic<uint64_t> oversizedFrames{ 0 };     // Connections closed for an invalid frame size
+            std::atomic<uint64_t> deferredReads{ 0 };       // Reads postponed because the budget was exhausted
+            std::atomic<uint64_t> refusedConnections{ 0 };  // Connections refused because the budget was exhausted
+
+            // Takes nBytes from the budget if they fit
+            bool reserve(size_t nBytes)
+            {
+                size_t current = used.load(std::memory_order_relaxed);
+                do
+                {
+                    if (current + nBytes > capacity)
+                        return false;
+                } while (!used.compare_exchange_weak(current, current + nBytes, std::memory_order_relaxed));
+                return true;
+            }
+
+            // Takes nBytes even past the capacity, for data that has already been received
+            // The bytes come back when the returned charge is destroyed
+            budget_charge charge(size_t nBytes)
+            {
+                used.fetch_add(nBytes, std::memory_order_relaxed);
+                return budget_charge(used, nBytes);
+            }
+
+            void release(size_t nBytes)
+            {
+                used.fetch_sub(nBytes, std::memory_order_relaxed);
+            }
+
+            bool exhausted() const
+            {
+                return used.load(std::memory_order_relaxed) >= capacity;
+            }
+
+            // Whether nBytes more would still fit, without taking them
+            bool canAdmit(size_t nBytes) const
+            {
+                return used.load(std::memory_order_relaxed) + nBytes <= capacity;
+            }
+        };
+
+        // How often the slow-consumer handling fired, shared by all connections of a server
+        struct outbound_counters
+        {
+            std::atomic<uint64_t> congestions{ 0 };   // Connections that crossed the high watermark
+            std::atomic<uint64_t> dropped{ 0 };       // Ephemeral frames discarded
+            std::atomic<uint64_t> collapsed{ 0 };     // Ephemeral frames replaced by a newer one
+            std::atomic<uint64_t> disconnects{ 0 };   // Connections closed for not reading
+        };
+
         // Template class representing a network connection that can be either client or server side
         template<typename T>
         class connection : public std::enable_shared_from_this<connection<T>>
@@ -24,7 +107,7 @@ namespace olc
 
             // Constructor for client connections (3 parameters)
             // Used when creating a connection from client side
-            connection(owner parent, boost::asio::io_context& asioContext, tsQueue<owned_message<T>>& qIn)
+            connection(owner parent, boost::asio::io_context& asioContext, mpscQueue<owned_message<T>>& qIn)
                 : m_asioContext(asioContext), m_socket(asioContext), m_qMessageIn(qIn)
             {
                 m_nOwnerType = parent;
@@ -44,8 +127,9 @@ namespace olc
 
             // Constructor for server connections (4 parameters)
             // Used when server accepts a new client connection
+            // The socket should be bound to its own strand so all of this connection's handlers are serialized
             connection(owner parent, boost::asio::io_context& asioContext, boost::asio::ip::tcp::socket socket,
-                tsQueue<owned_message<T>>& qIn)
+                mpscQueue<owned_message<T>>& qIn)
                 : m_asioContext(asioContext), m_socket(std::move(socket)), m_qMessageIn(qIn)
             {
                 m_nOwnerType = parent;
@@ -55,6 +139,9 @@ namespace olc
                 {
                     m_nHandshakeOut = uint64_t(std::chrono::system_clock::now().time_since_epoch().count());
                     m_nHandshakeCheck = scramble(m_nHandshakeOut);
+
+                    // Hold frames queued before connectToClient() until the handshake has been written
+                    m_bWriting = true;
                 }
                 else
                 {
@@ -63,7 +150,15 @@ namespace olc
                 }
             }
 
-            virtual ~connection() {}
+            // Free space requested for every read; the smallest receive buffer a connection holds
+            static constexpr size_t RECEIVE_CHUNK_SIZE = 16 * 1024;
+
+            virtual ~connection()
+            {
+                // Give the receive buffer back to the server's budget
+                if (m_pInboundBudget)
+                    m_pInboundBudget->release(m_vRecvBuffer.size());
+            }
 
             // Returns the unique ID of this connection
             uint32_t getID() const
@@ -86,10 +181,14 @@ namespace olc
                     if (m_socket.is_open())
                     {
                         id = uid;
+                        m_pServer = server;
 
-                        // ReadHeader();
-                        WriteValidation();
-                        ReadValidation(server);
+                        // Start on the connection's strand so the handshake is the first write on the socket
+                        boost::asio::post(m_socket.get_executor(), [this, self = this->shared_from_this(), server]()
+                            {
+                                WriteValidation();
+                                ReadValidation(server);
+                            });
                     }
                 }
             }
@@ -106,7 +205,6 @@ namespace olc
                             if (!ec)
                             {
                                 // Start reading messages from the server
-                                // ReadHeader();
                                 ReadValidation();
                             }
                         });
@@ -119,39 +217,109 @@ namespace olc
             {
                 if (isConnected())
                 {
-                    boost::asio::post(m_asioContext, [this]() { m_socket.close(); });
+                    boost::asio::post(m_socket.get_executor(), [this, self = this->shared_from_this()]() { m_socket.close(); });
                 }
                 return true;
             }
 
+            // When data last arrived from the peer (or the connection was created); safe from any thread
+            std::chrono::steady_clock::time_point lastReceived() const
+            {
+                return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(m_nLastReceived.load(std::memory_order_relaxed)));
+            }
+
             // Checks if the connection is still active
             bool isConnected() const
             {
-                return m_socket.is_open() && !m_isRemoved;
+                return m_socket.is_open() && !m_isRemoved.load(std::memory_order_acquire);
+            }
+
+            // Marks the connection as removed from the server; isConnected() is false from here on, even while
+            // the socket is still open. Set before the disconnect handler runs, so state registered under a lock
+            // after checking isConnected() is either seen by that handler or never registered
+            void markRemoved()
+            {
+                m_isRemoved.store(true, std::memory_order_release);
             }
 
             // Sends a message through this connection
-            // Adds message to outgoing queue and triggers write if needed
+            // Serializes it once and queues the resulting frame
             bool send(const message<T>& msg)
             {
-                boost::asio::post(m_asioContext,
-                    [this, msg]()
+                return send(make_shared_frame(msg));
+            }
+
+            // Sends a pre-serialized frame through this connection
+            // The frame is shared, not copied, so it can be queued on many connections at once
+            bool send(shared_frame<T> frame)
+            {
+                // Runs on the connection's strand, so the outgoing queue is never touched concurrently
+                // A frame sent by a traced message's handler completes that message's trace once written
+                boost::asio::post(m_socket.get_executor(),
+                    [this, self = this->shared_from_this(), frame = std::move(frame), trace = current_trace()]() mutable
                     {
-                        bool writingMessage = !m_qMessageOut.empty();
+                        if (!admitFrame(frame, trace))
+                        {
+                            publishOutbound();
+                            return;
+                        }
 
-                        // Create a copy of the message for sending
-                        message<T> msgCopy = msg;
+                        Metrics::instance().record(Metrics::HistogramId::OutboundDepth, m_qMessageOut.size());
+                        m_nOutboundBytes += frame->size();
+                        m_qMessageOut.push_back(std::move(frame));
+                        if (trace)
+                            m_qWriteTraces.emplace_back(m_nFramesQueued, std::move(trace));
+                        m_nFramesQueued++;
+                        publishOutbound();
 
-                        m_qMessageOut.push_back(msgCopy);
-                        if (!writingMessage)
+                        // Frames queued while a write is in flight go out with the next batch
+                        if (!m_bWriting)
                         {
-                            writeHeader();
+                            writeFrames();
                         }
                     });
                 return true;
             }
 
-        private:
+            // Frames and bytes queued or being written; safe from any thread, updated as the queue changes
+            size_t outboundFrames() const
+            {
+                return m_nPublishedFrames.load(std::memory_order_relaxed);
+            }
+
+            size_t outboundBytes() const
+            {
+                return m_nPublishedBytes.load(std::memory_order_relaxed);
+            }
+
+            // Sets the maximum number of bytes gathered into a single write
+            void setWriteBatchBudget(size_t nBytes)
+            {
+                m_nWriteBatchBudget = nBytes;
+            }
+
+            // Traces one in every oneIn incoming messages (0 = none). Must be called before the connection starts reading
+            void setTraceSampling(uint32_t oneIn)
+            {
+                m_nTraceSampling = oneIn;
+            }
+
+            // Applies frame size limits and the server's receive budget (may be null) to incoming data
+            // Must be called before the connection starts reading
+            void setInboundLimits(const inbound_limits& limits, inbound_budget* budget)
+            {
+                m_inboundLimits = limits;
+                m_pInboundBudget = budget;
+            }
+
+            // Bounds the outgoing queue; counters (may be null) record every time the policy fires
+            // Must be called before the connection is shared with other threads
+            void setOutboundLimits(const outbound_limits& limits, outbound_counters* counters)
+            {
+                m_outboundLimits = limits;
+                m_pOutboundCounters = counters;
+            }
+
             // Validates username according to specified rules
             bool validateUsername(const std::string& username, std::string& errorMsg) {
                 // Check minimum and maximum length
@@ -186,8 +354,8 @@ namespace olc
                     [](unsigned char c) { return std::tolower(c); });
 
                 for (const auto& name : forbiddenNames) {
-                    // If username matches one of forbidden names, reject it (except "admin")
-                    if (name == lowercaseUsername && name != "admin") {
+                    // If username matches one of forbidden names, reject it
+                    if (name == lowercaseUsername) {
                         errorMsg = "This username is reserved by system";
                         return false;
                     }
@@ -242,55 +410,191 @@ namespace olc
             }
 
         protected:
-            // Asynchronously writes message header to the socket
-            void writeHeader()
+            // Applies the outbound limits to a frame about to be queued; returns false if it must not be queued
+            // Runs on the connection's strand; trace is the frame's write trace, taken over if it collapses
+            bool admitFrame(const shared_frame<T>& frame, trace_ptr& trace)
             {
-                boost::asio::async_write(m_socket,
-                    boost::asio::buffer(&m_qMessageOut.front().header, sizeof(messageHeader<T>)),
-                    [this](boost::system::error_code ec, std::size_t length)
+                // Nothing is written on a closed socket, do not let frames pile up
+                if (!m_socket.is_open())
+                    return false;
+
+                if (!m_bCongested && m_nOutboundBytes + frame->size() > m_outboundLimits.highWatermark)
+                {
+                    m_bCongested = true;
+                    countOutbound(&outbound_counters::congestions);
+                    LOG_WARN("[" << id << "] Outgoing queue above high watermark (" << m_nOutboundBytes << " bytes)");
+                }
+
+                if (m_bCongested)
+                {
+                    switch (m_outboundLimits.policy)
                     {
-                        if (!ec)
+                    case slow_consumer_policy::disconnect:
+                        closeSlowConsumer();
+                        return false;
+
+                    case slow_consumer_policy::collapse_ephemeral:
+                        if (frame->delivery() == frame_delivery::ephemeral && frame->collapseKey() != 0)
                         {
-                            if (m_qMessageOut.front().body.size() > 0)
-                            {
-                                writeBody();
-                            }
-                            else
-                            {
-                                m_qMessageOut.pop_front();
-                                if (!m_qMessageOut.empty())
-                                {
-                                    writeHeader();
-                                }
-                            }
+                            if (!collapseFrame(frame, trace))
+                                break; // Nothing to replace yet, queue it
+                            countOutbound(&outbound_counters::collapsed);
+                            return false;
                         }
-                        else
+                        [[fallthrough]];
+
+                    case slow_consumer_policy::drop_ephemeral:
+                        if (frame->delivery() == frame_delivery::ephemeral)
                         {
-                            std::cerr << "[" << this << "] Write Header Failed: " << ec.message() << std::endl;
-                            m_socket.close();
+                            countOutbound(&outbound_counters::dropped);
+                            return false;
                         }
-                    });
+                        break;
+                    }
+                }
+
+                if (m_nOutboundBytes + frame->size() > m_outboundLimits.maxQueuedBytes)
+                {
+                    closeSlowConsumer();
+                    return false;
+                }
+
+                return true;
+            }
+
+            // Replaces the newest queued (not yet writing) ephemeral frame with the same collapse key
+            // Returns false if there is none
+            bool collapseFrame(const shared_frame<T>& frame, trace_ptr& trace)
+            {
+                for (auto it = m_qMessageOut.rbegin(); it != m_qMessageOut.rend(); ++it)
+                {
+                    if ((*it)->delivery() == frame_delivery::ephemeral && (*it)->collapseKey() == frame->collapseKey())
+                    {
+                        m_nOutboundBytes = m_nOutboundBytes - (*it)->size() + frame->size();
+                        *it = frame;
+
+                        // The replaced frame is never written: its trace leaves the slot and the new frame's takes it
+                        uint64_t slot = m_nFramesWritten + m_vWriteBatch.size() + uint64_t(std::distance(it, m_qMessageOut.rend()) - 1);
+                        auto traced = std::lower_bound(m_qWriteTraces.begin(), m_qWriteTraces.end(), slot,
+                            [](const std::pair<uint64_t, trace_ptr>& entry, uint64_t frameIndex) { return entry.first < frameIndex; });
+                        bool occupied = traced != m_qWriteTraces.end() && traced->first == slot;
+                        if (trace && occupied)
+                            traced->second = std::move(trace);
+                        else if (trace)
+                            m_qWriteTraces.emplace(traced, slot, std::move(trace));
+                        else if (occupied)
+                            m_qWriteTraces.erase(traced);
+                        return true;
+                    }
+                }
+                return false;
             }
 
-            // Asynchronously writes message body to the socket
-            void writeBody()
+            // Closes a connection that stopped reading and releases its queued frames
+            void closeSlowConsumer()
             {
-                boost::asio::async_write(m_socket,
-                    boost::asio::buffer(m_qMessageOut.front().body.data(), m_qMessageOut.front().body.size()),
-                    [this](std::error_code ec, std::size_t length)
-                    // boost::system::error_code ec
+                countOutbound(&outbound_counters::disconnects);
+                LOG_WARN("[" << id << "] Closing slow consumer with " << m_nOutboundBytes << " bytes queued");
+
+                // The write in flight fails once the socket is closed and releases its own bytes
+                for (const auto& queued : m_qMessageOut)
+                    m_nOutboundBytes -= queued->size();
+                m_qMessageOut.clear();
+                dropWriteTraces();
+                m_bCongested = false;
+                publishOutbound();
+                m_socket.close();
+            }
+
+            // Makes the outgoing queue size visible to statistics readers. Runs on the connection's strand
+            void publishOutbound()
+            {
+                m_nPublishedFrames.store(m_qMessageOut.size() + m_vWriteBatch.size(), std::memory_order_relaxed);
+                m_nPublishedBytes.store(m_nOutboundBytes, std::memory_order_relaxed);
+            }
+
+            // Forgets the traces of frames that will not be written; keeps the frame count in step with the queue
+            void dropWriteTraces()
+            {
+                m_qWriteTraces.clear();
+                m_nFramesQueued = m_nFramesWritten + m_vWriteBatch.size() + m_qMessageOut.size();
+            }
+
+            void countOutbound(std::atomic<uint64_t> outbound_counters::* counter)
+            {
+                if (m_pOutboundCounters)
+                    (m_pOutboundCounters->*counter).fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // Asynchronously writes all currently queued frames with one vectored write
+            // Gathers frames until the byte budget is reached (always at least one frame)
+            void writeFrames()
+            {
+                // The previous batch has been written
+                for (const auto& written : m_vWriteBatch)
+                    Metrics::instance().messageOut(static_cast<uint32_t>(written->id()), written->size());
+                m_nFramesWritten += m_vWriteBatch.size();
+                if (!m_qWriteTraces.empty())
+                {
+                    auto now = message_trace::clock::now();
+                    while (!m_qWriteTraces.empty() && m_qWriteTraces.front().first < m_nFramesWritten)
+                    {
+                        m_qWriteTraces.front().second->writeCompleted(now);
+                        m_qWriteTraces.pop_front();
+                    }
+                }
+                m_nOutboundBytes -= m_nBatchBytes;
+                m_nBatchBytes = 0;
+                m_vWriteBatch.clear();
+                m_vWriteBuffers.clear();
+
+                if (m_bCongested && m_nOutboundBytes <= m_outboundLimits.lowWatermark)
+                {
+                    m_bCongested = false;
+                    LOG_INFO("[" << id << "] Outgoing queue drained below low watermark");
+                }
+
+                size_t nBatchBytes = 0;
+                while (!m_qMessageOut.empty() && m_vWriteBatch.size() < MAX_WRITE_BATCH_FRAMES)
+                {
+                    const shared_frame<T>& next = m_qMessageOut.front();
+                    if (!m_vWriteBatch.empty() && nBatchBytes + next->size() > m_nWriteBatchBudget)
+                        break;
+
+                    nBatchBytes += next->size();
+                    m_vWriteBuffers.emplace_back(next->data(), next->size());
+                    m_vWriteBatch.push_back(next);
+                    m_qMessageOut.pop_front();
+                }
+
+                m_nBatchBytes = nBatchBytes;
+                publishOutbound();
+
+                if (m_vWriteBatch.empty())
+                {
+                    m_bWriting = false;
+                    return;
+                }
+
+                m_bWriting = true;
+                boost::asio::async_write(m_socket, m_vWriteBuffers,
+                    [this, self = this->shared_from_this()](boost::system::error_code ec, [[maybe_unused]] std::size_t length)
                     {
                         if (!ec)
                         {
-                            m_qMessageOut.pop_front();
-                            if (!m_qMessageOut.empty())
-                            {
-                                writeHeader();
-                            }
+                            // Release the written frames and continue with anything queued meanwhile
+                            writeFrames();
                         }
                         else
                         {
-                            std::cerr << "[" << this << "] Write Body Failed: " << ec.message() << std::endl;
+                            LOG_ERROR("[" << this << "] Write Failed: " << ec.message());
+                            m_bWriting = false;
+                            m_nOutboundBytes -= m_nBatchBytes;
+                            m_nBatchBytes = 0;
+                            m_vWriteBatch.clear();
+                            m_vWriteBuffers.clear();
+                            dropWriteTraces();
+                            publishOutbound();
                             m_socket.close();
                         }
                     });
@@ -298,7 +602,7 @@ namespace olc
 
             protected:
                 // Flag to track if connection has been marked for removal
-                bool m_isRemoved = false;
+                std::atomic<bool> m_isRemoved{ false };
 
         public:
                 // Safely removes client connection from server
@@ -309,108 +613,263 @@ namespace olc
                         // Close connection if it's still open
                         if (isConnected())
                         {
-                            std::cout << "[" << id << "] Client disconnected, closing connection" << std::endl;
+                            LOG_INFO("[" << id << "] Client disconnected, closing connection");
 
-                            // Schedule socket closure through asio for thread safety
-                            boost::asio::post(m_asioContext, [this]() {
+                            // Schedule socket closure and outgoing queue cleanup on the connection's strand
+                            boost::asio::post(m_socket.get_executor(), [this, self = this->shared_from_this()]() {
                                 m_socket.close();
+                                for (const auto& queued : m_qMessageOut)
+                                    m_nOutboundBytes -= queued->size();
+                                m_qMessageOut.clear();
+                                dropWriteTraces();
+                                publishOutbound();
                                 });
 
-                            // Clear outgoing message queue
-                            while (!m_qMessageOut.empty())
-                                m_qMessageOut.pop_front();
-
                             // Mark connection as removed (could be useful for cleanup logic)
                             // m_isRemoved = true;  // This flag might be used later
                         }
+
+                        // Let the server release the connection's registry slot
+                        server->notifyConnectionClosed(this->shared_from_this());
                     }
                 }
 
 
         private:
-            // Asynchronously reads message header from the socket
-            void ReadHeader()
+            // Asynchronously reads whatever bytes are available into the receive buffer
+            // Each completed read may deliver any number of complete (or partial) frames
+            void ReadFrames()
             {
-                // Initialize temporary message for incoming data
-                m_tempMsg = message<T>();
+                // Room for a chunk, or for the rest of a partially received frame
+                if (!prepareReceiveSpace(std::max(RECEIVE_CHUNK_SIZE, m_nRecvMissing)) ||
+                    (m_pInboundBudget && m_pInboundBudget->exhausted()))
+                {
+                    DeferRead();
+                    return;
+                }
+
+                if (m_bReadDeferred)
+                {
+                    m_bReadDeferred = false;
+                    LOG_INFO("[" << id << "] Receive budget available again, resuming reads");
+                }
 
-                // Use weak_ptr and lock for safe shared_ptr handling
-                boost::asio::async_read(m_socket,
-                    boost::asio::buffer(&m_tempMsg.header, sizeof(messageHeader<T>)),
-                    [this](std::error_code ec, std::size_t length)
+                m_socket.async_read_some(
+                    boost::asio::buffer(m_vRecvBuffer.data() + m_nRecvEnd, m_vRecvBuffer.size() - m_nRecvEnd),
+                    [this, self = this->shared_from_this()](boost::system::error_code ec, std::size_t length)
                     {
                         if (!ec)
                         {
-                            std::cout << "[" << id << "] Received header, ID=" << static_cast<uint32_t>(m_tempMsg.header.id)
-                                << ", Size=" << m_tempMsg.header.size << std::endl;
-
-                            if (m_tempMsg.header.size > 0)
-                            {
-                                // Calculate body size: total message size minus header size
-                                size_t bodySize = m_tempMsg.header.size - sizeof(messageHeader<T>);
-                                if (bodySize > 0) {
-                                    m_tempMsg.body.resize(bodySize);
-                                    ReadBody();
-                                }
-                                else {
-                                    // Message has no body, process immediately
-                                    AddToIncomingMessageQueue();
-                                }
-                            }
-                            else
-                            {
-                                // If message body is empty, add message to queue immediately
-                                AddToIncomingMessageQueue();
-                            }
+                            m_nRecvEnd += length;
+                            auto now = std::chrono::steady_clock::now();
+                            m_nLastReceived.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+                            if (ParseFrames(now))
+                                ReadFrames();
                         }
                         else
                         {
-                            std::cerr << "[" << id << "] Read Header Failed: " << ec.message() << std::endl;
+                            LOG_ERROR("[" << id << "] Read Failed: " << ec.message());
                             m_socket.close();
+                            releaseReceiveBuffer();
+                            if (m_pServer)
+                                m_pServer->notifyConnectionClosed(this->shared_from_this());
                         }
                     });
             }
 
-            // Asynchronously reads message body from the socket
-            void ReadBody()
+            // Retries reading later while the server's receive budget is exhausted
+            // Unread data stays in the socket, so TCP flow control slows the peer down meanwhile
+            // A throttled connection counts as active, so the heartbeat does not reap it for the server's own
+            // backpressure; its idle time starts again once reads resume
+            void DeferRead()
             {
-                // Don't use shared_from_this() here
-                boost::asio::async_read(m_socket,
-                    boost::asio::buffer(m_tempMsg.body.data(), m_tempMsg.body.size()),
-                    [this](boost::system::error_code ec, std::size_t length)
+                m_nLastReceived.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+
+                if (!m_bReadDeferred)
+                {
+                    m_bReadDeferred = true;
+                    m_pInboundBudget->deferredReads.fetch_add(1, std::memory_order_relaxed);
+                    LOG_WARN("[" << id << "] Receive budget exhausted, pausing reads");
+                }
+
+                m_readRetryTimer.expires_after(READ_RETRY_DELAY);
+                m_readRetryTimer.async_wait([this, self = this->shared_from_this()](boost::system::error_code ec)
                     {
-                        if (!ec)
+                        if (!ec && m_socket.is_open())
                         {
-                            std::cout << "[" << id << "] Received body, Size=" << length << std::endl;
-                            AddToIncomingMessageQueue();
+                            ReadFrames();
                         }
                         else
                         {
-                            std::cerr << "[" << id << "] Read Body Failed: " << ec.message() << std::endl;
-                            m_socket.close();
+                            // The connection closed while reads were paused, nothing else reports it
+                            releaseReceiveBuffer();
+                            if (m_pServer)
+                                m_pServer->notifyConnectionClosed(this->shared_from_this());
                         }
                     });
             }
 
-            // Adds complete message to incoming message queue
-            void AddToIncomingMessageQueue()
+            // Extracts every complete frame currently held in the receive buffer, received by the read at readTime
+            // Returns false (and closes the connection) if a frame header is invalid
+            bool ParseFrames(std::chrono::steady_clock::time_point readTime)
+            {
+                m_nRecvMissing = 0;
+
+                while (m_nRecvEnd - m_nRecvStart >= sizeof(messageHeader<T>))
+                {
+                    const uint8_t* pFrame = m_vRecvBuffer.data() + m_nRecvStart;
+
+                    messageHeader<T> header;
+                    std::memcpy(&header, pFrame, sizeof(messageHeader<T>));
+
+                    // header.size is the total message size, 0 means no body
+                    // Check it against the type's limit before buffering any of the body
+                    if (!validFrameSize(header))
+                    {
+                        if (m_pInboundBudget)
+                            m_pInboundBudget->oversizedFrames.fetch_add(1, std::memory_order_relaxed);
+                        LOG_WARN("[" << id << "] Invalid frame size " << header.size << " for message type "
+                            << static_cast<uint32_t>(header.id) << ", closing connection");
+                        m_socket.close();
+                        releaseReceiveBuffer();
+                        if (m_pServer)
+                            m_pServer->notifyConnectionClosed(this->shared_from_this());
+                        return false;
+                    }
+
+                    size_t bodySize = header.size > sizeof(messageHeader<T>) ? header.size - sizeof(messageHeader<T>) : 0;
+                    size_t frameSize = sizeof(messageHeader<T>) + bodySize;
+
+                    if (m_nRecvEnd - m_nRecvStart < frameSize)
+                    {
+                        // Partial frame, the next read makes room for all of it
+                        m_nRecvMissing = frameSize - (m_nRecvEnd - m_nRecvStart);
+                        if (m_tPartialHeader == std::chrono::steady_clock::time_point())
+                            m_tPartialHeader = readTime;
+                        break;
+                    }
+
+                    message<T> msg;
+                    msg.header = header;
+                    msg.body.assign(pFrame + sizeof(messageHeader<T>), pFrame + frameSize);
+                    m_nRecvStart += frameSize;
+
+                    if (sampleTrace())
+                    {
+                        msg.trace = std::make_shared<message_trace>();
+                        msg.trace->headerRead = m_tPartialHeader != std::chrono::steady_clock::time_point() ? m_tPartialHeader : readTime;
+                        msg.trace->bodyRead = readTime;
+                    }
+                    m_tPartialHeader = std::chrono::steady_clock::time_point();
+
+                    AddToIncomingMessageQueue(std::move(msg));
+                }
+
+                // Everything consumed, rewind to the beginning of the buffer
+                if (m_nRecvStart == m_nRecvEnd)
+                {
+                    m_nRecvStart = 0;
+                    m_nRecvEnd = 0;
+
+                    // Give back the memory a large frame needed
+                    if (m_vRecvBuffer.size() > RECEIVE_CHUNK_SIZE)
+                    {
+                        if (m_pInboundBudget)
+                            m_pInboundBudget->release(m_vRecvBuffer.size() - RECEIVE_CHUNK_SIZE);
+                        m_vRecvBuffer.resize(RECEIVE_CHUNK_SIZE);
+                        m_vRecvBuffer.shrink_to_fit();
+                    }
+                }
+                return true;
+            }
+
+            // Picks one in every m_nTraceSampling frames for tracing
+            bool sampleTrace()
+            {
+                if (m_nTraceSampling == 0 || ++m_nTraceCountdown < m_nTraceSampling)
+                    return false;
+                m_nTraceCountdown = 0;
+                return true;
+            }
+
+            // Returns the receive buffer to the budget once nothing more will be read
+            // Closed connections may stay registered with the server for a while, their buffers should not
+            void releaseReceiveBuffer()
+            {
+                if (m_pInboundBudget)
+                    m_pInboundBudget->release(m_vRecvBuffer.size());
+                m_vRecvBuffer.clear();
+                m_vRecvBuffer.shrink_to_fit();
+                m_nRecvStart = 0;
+                m_nRecvEnd = 0;
+            }
+
+            // A frame is either header-only (size 0 or the header size) or within its type's limit
+            bool validFrameSize(const messageHeader<T>& header) const
+            {
+                if (header.size == 0)
+                    return true;
+                if (header.size < sizeof(messageHeader<T>))
+                    return false;
+                if (m_nOwnerType != owner::server)
+                    return true;
+
+                size_t type = static_cast<size_t>(header.id);
+                uint32_t limit = type < m_inboundLimits.maxFrameSize.size() && m_inboundLimits.maxFrameSize[type] != 0
+                    ? m_inboundLimits.maxFrameSize[type]
+                    : m_inboundLimits.defaultMaxFrameSize;
+                return header.size <= limit;
+            }
+
+            // Ensures at least nBytes of free space after the buffered data
+            // Slides unconsumed bytes to the front first and grows the buffer only if that is not enough
+            // Returns false if the server's receive budget cannot cover the growth
+            bool prepareReceiveSpace(size_t nBytes)
+            {
+                if (m_vRecvBuffer.size() - m_nRecvEnd >= nBytes)
+                    return true;
+
+                if (m_nRecvStart > 0)
+                {
+                    std::memmove(m_vRecvBuffer.data(), m_vRecvBuffer.data() + m_nRecvStart, m_nRecvEnd - m_nRecvStart);
+                    m_nRecvEnd -= m_nRecvStart;
+                    m_nRecvStart = 0;
+                }
+
+                if (m_vRecvBuffer.size() - m_nRecvEnd < nBytes)
+                {
+                    size_t newSize = std::max(m_nRecvEnd + nBytes, std::min(m_vRecvBuffer.size() * 2, m_nRecvEnd + nBytes + RECEIVE_CHUNK_SIZE));
+                    if (m_pInboundBudget && !m_pInboundBudget->reserve(newSize - m_vRecvBuffer.size()))
+                        return false;
+                    m_vRecvBuffer.resize(newSize);
+                }
+                return true;
+            }
+
+            // Moves a complete message into the incoming message queue
+            void AddToIncomingMessageQueue(message<T>&& msg)
             {
                 // Create ownership info and add message to queue
-                std::cout << "[" << id << "] Adding message to queue, ID=" << static_cast<int>(m_tempMsg.header.id) << std::endl;
+                LOG_DEBUG("[" << id << "] Adding message to queue, ID=" << static_cast<int>(msg.header.id)
+                    << ", Size=" << msg.header.size);
 
                 // If we're server, attach connection info to message
                 if (m_nOwnerType == owner::server)
                 {
-                    m_qMessageIn.push_back({ this->shared_from_this(), m_tempMsg });
+                    // Held against the budget until the message is destroyed after its handler ran
+                    if (m_pInboundBudget)
+                        msg.charge = m_pInboundBudget->charge(msg.body.size());
+                    Metrics::instance().messageIn(static_cast<uint32_t>(msg.header.id), msg.size());
+                    if (msg.trace)
+                        msg.trace->enqueued = message_trace::clock::now();
+                    size_t depth = m_qMessageIn.push_back({ this->shared_from_this(), std::move(msg) });
+                    Metrics::instance().record(Metrics::HistogramId::IncomingDepth, depth);
                 }
                 else
                 {
                     // If we're client, add message without connection info
-                    m_qMessageIn.push_back({ nullptr, m_tempMsg });
+                    m_qMessageIn.push_back({ nullptr, std::move(msg) });
                 }
-
-                // After adding message to queue, start reading next message
-                ReadHeader();
             }
 
             // Encrypts data using simple scrambling algorithm
@@ -425,12 +884,14 @@ namespace olc
             void WriteValidation()
             {
                 boost::asio::async_write(m_socket, boost::asio::buffer(&m_nHandshakeOut, sizeof(uint64_t)),
-                    [this](std::error_code ec, std::size_t length)
+                    [this, self = this->shared_from_this()](std::error_code ec, std::size_t length)
                     {
                         if (!ec)
                         {
                             if (m_nOwnerType == owner::client)
-                                ReadHeader();
+                                ReadFrames();
+                            else
+                                writeFrames(); // Flush frames queued while the handshake was in flight
                         }
                         else
                         {
@@ -444,7 +905,7 @@ namespace olc
             void ReadValidation(olc::net::server_interface<T>* server = nullptr)
             {
                 boost::asio::async_read(m_socket, boost::asio::buffer(&m_nHandshakeIn, sizeof(uint64_t)),
-                    [this, server](std::error_code ec, std::size_t length)
+                    [this, self = this->shared_from_this(), server](std::error_code ec, std::size_t length)
                     {
                         if (!ec)
                         {
@@ -452,15 +913,15 @@ namespace olc
                             {
                                 if (m_nHandshakeIn == m_nHandshakeCheck)
                                 {
-                                    std::cout << "Client successfully validated\n";
+                                    LOG_INFO("Client successfully validated");
                                     if (server) {  // Ensure server is not null
                                         server->onClientValidated(this->shared_from_this());
                                     }
-                                    ReadHeader();
+                                    ReadFrames();
                                 }
                                 else
                                 {
-                                    std::cout << "Client validation failed (handshake mismatch)\n";
+                                    LOG_WARN("Client validation failed (handshake mismatch)");
                                     // Use removeClient method instead of direct socket closure
                                     if (server) {
                                         removeClient(server);
@@ -478,7 +939,7 @@ namespace olc
                         }
                         else
                         {
-                            std::cout << "Client validation failed (ReadValidation error)\n";
+                            LOG_WARN("Client validation failed (ReadValidation error)");
                             // Use removeClient method instead of direct socket closure
                             if (m_nOwnerType == owner::server && server) {
                                 removeClient(server);
@@ -495,17 +956,59 @@ namespace olc
             boost::asio::ip::tcp::socket m_socket;
             boost::asio::io_context& m_asioContext;
 
-            // Temporary message storage for incoming data
-            message<T> m_tempMsg;
-
-            // Thread-safe queue for outgoing messages
-            tsQueue<message<T>> m_qMessageOut;
+            // Receive buffer filled by async_read_some, bytes [m_nRecvStart, m_nRecvEnd) are not yet parsed
+            std::vector<uint8_t> m_vRecvBuffer;
+            size_t m_nRecvStart = 0;
+            size_t m_nRecvEnd = 0;
+            size_t m_nRecvMissing = 0;      // Bytes still to receive for the partial frame at m_nRecvStart
+            std::chrono::steady_clock::time_point m_tPartialHeader;    // When the partial frame's header arrived
+
+            // Sampling of incoming messages for latency tracing
+            uint32_t m_nTraceSampling = 0;
+            uint32_t m_nTraceCountdown = 0;
+
+            // Incoming frame size limits and the server's receive budget
+            inbound_limits m_inboundLimits;
+            inbound_budget* m_pInboundBudget = nullptr;
+
+            // Retries reads postponed while the receive budget is exhausted
+            static constexpr std::chrono::milliseconds READ_RETRY_DELAY{ 10 };
+            boost::asio::steady_timer m_readRetryTimer{ m_socket.get_executor() };
+            bool m_bReadDeferred = false;
+
+            // Outgoing serialized frames, only touched on the connection's strand
+            std::deque<shared_frame<T>> m_qMessageOut;
+
+            // Bytes queued in m_qMessageOut plus the write in flight, kept within m_outboundLimits
+            outbound_limits m_outboundLimits;
+            outbound_counters* m_pOutboundCounters = nullptr;
+            size_t m_nOutboundBytes = 0;
+            bool m_bCongested = false;
+            std::atomic<size_t> m_nPublishedFrames{ 0 };   // Copies of the queue size for other threads
+            std::atomic<size_t> m_nPublishedBytes{ 0 };
+
+            // Frames and buffers of the write currently in flight
+            static constexpr size_t MAX_WRITE_BATCH_FRAMES = 64; // Matches asio's per-call scatter-gather limit
+            std::vector<shared_frame<T>> m_vWriteBatch;
+            std::vector<boost::asio::const_buffer> m_vWriteBuffers;
+            size_t m_nWriteBatchBudget = 64 * 1024;
+            size_t m_nBatchBytes = 0;
+            bool m_bWriting = false;
+
+            // Traces waiting for a queued frame to be written, keyed by the frame's position in the send order
+            std::deque<std::pair<uint64_t, trace_ptr>> m_qWriteTraces;
+            uint64_t m_nFramesQueued = 0;
+            uint64_t m_nFramesWritten = 0;
             // Reference to shared incoming message queue
-            tsQueue<owned_message<T>>& m_qMessageIn;
+            mpscQueue<owned_message<T>>& m_qMessageIn;
             // Specifies whether this connection belongs to server or client
             owner m_nOwnerType = owner::server;
             // Unique identifier for this connection
             uint32_t id = 0;
+            // Server that accepted this connection, told when it closes
+            server_interface<T>* m_pServer = nullptr;
+            // Steady clock time of the last completed read, checked by the server's heartbeat
+            std::atomic<std::chrono::steady_clock::rep> m_nLastReceived{ std::chrono::steady_clock::now().time_since_epoch().count() };
 
             // Handshake validation data
             uint64_t m_nHandshakeOut = 0;
@@ -0,0 +1,169 @@
+#pragma once
+#include "net_common.h"
+#include <array>
+#include <atomic>
+#include <memory>
+
+namespace olc
+{
+    namespace net
+    {
+        template<typename T>
+        class connection;
+
+        // Slot map of live connections keyed by generational IDs
+        // An ID is (generation << SLOT_BITS) | slot index. Removing a connection bumps its slot's generation,
+        // so an ID kept after the connection is gone never resolves to whichever connection reuses the slot.
+        // find() and forEach() take no lock and can run on any thread; insert() and remove() are O(1) and
+        // serialized by a writer mutex. Slots live in fixed chunks that are never moved or freed while the
+        // registry exists, so readers never see storage change under them.
+        template<typename T>
+        class connectionRegistry
+        {
+        public:
+            // 17 bits hold 131072 connections; the remaining 15 bits count a slot's generations
+            static constexpr uint32_t SLOT_BITS = 17;
+            static constexpr uint32_t MAX_SLOTS = 1u << SLOT_BITS;
+            static constexpr uint32_t MAX_GENERATION = (1u << (32 - SLOT_BITS)) - 1;
+
+            connectionRegistry()
+            {
+                for (auto& chunk : m_chunks)
+                    chunk.store(nullptr, std::memory_order_relaxed);
+            }
+
+            connectionRegistry(const connectionRegistry<T>&) = delete;
+            connectionRegistry<T>& operator=(const connectionRegistry<T>&) = delete;
+
+            ~connectionRegistry()
+            {
+                for (auto& chunk : m_chunks)
+                    delete chunk.load(std::memory_order_relaxed);
+            }
+
+            // Stores a connection and returns its new ID, or 0 if every slot is taken
+            uint32_t insert(std::shared_ptr<connection<T>> conn)
+            {
+                std::lock_guard<std::mutex> lock(m_muxWriters);
+
+                uint32_t index = 0;
+                if (!m_freeSlots.empty())
+                {
+                    // Reuse the longest-free slot so generations of one slot advance slowly
+                    index = m_freeSlots.front();
+                    m_freeSlots.pop_front();
+                }
+                else
+                {
+                    index = m_nSlotsUsed.load(std::memory_order_relaxed);
+                    if (index >= MAX_SLOTS)
+                        return 0;
+
+                    if (index % CHUNK_SIZE == 0)
+                        m_chunks[index / CHUNK_SIZE].store(new Chunk(), std::memory_order_release);
+                }
+
+                Slot& slot = slotAt(index);
+                uint32_t id = (slot.generation << SLOT_BITS) | index;
+
+                // The ID goes first: a reader that sees the new connection also sees the ID it belongs to
+                slot.id.store(id, std::memory_order_release);
+                std::atomic_store_explicit(&slot.conn, std::move(conn), std::memory_order_release);
+
+                if (index == m_nSlotsUsed.load(std::memory_order_relaxed))
+                    m_nSlotsUsed.store(index + 1, std::memory_order_release);
+                m_nLive.fetch_add(1, std::memory_order_relaxed);
+                return id;
+            }
+
+            // Returns the connection with this ID, or nullptr if it has been removed (or never existed)
+            std::shared_ptr<connection<T>> find(uint32_t id) const
+            {
+                uint32_t index = id & (MAX_SLOTS - 1);
+                if (index >= m_nSlotsUsed.load(std::memory_order_acquire))
+                    return nullptr;
+
+                const Slot& slot = slotAt(index);
+                std::shared_ptr<connection<T>> conn = std::atomic_load_explicit(&slot.conn, std::memory_order_acquire);
+                if (!conn || slot.id.load(std::memory_order_acquire) != id)
+                    return nullptr;
+                return conn;
+            }
+
+            // Removes the connection with this ID if the slot still holds conn (null matches any connection)
+            // Returns false if it was already gone
+            bool remove(uint32_t id, const std::shared_ptr<connection<T>>& conn = nullptr)
+            {
+                std::lock_guard<std::mutex> lock(m_muxWriters);
+
+                uint32_t index = id & (MAX_SLOTS - 1);
+                if (index >= m_nSlotsUsed.load(std::memory_order_relaxed))
+                    return false;
+
+                Slot& slot = slotAt(index);
+                if (slot.id.load(std::memory_order_relaxed) != id)
+                    return false;
+
+                std::shared_ptr<connection<T>> current = std::atomic_load_explicit(&slot.conn, std::memory_order_relaxed);
+                if (!current || (conn && current != conn))
+                    return false;
+
+                // Clear the connection before retiring the ID, generation 0 is skipped so no ID is ever 0
+                std::atomic_store_explicit(&slot.conn, std::shared_ptr<connection<T>>(), std::memory_order_release);
+                slot.generation = slot.generation == MAX_GENERATION ? 1 : slot.generation + 1;
+                slot.id.store(0, std::memory_order_release);
+
+                m_freeSlots.push_back(index);
+                m_nLive.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+
+            // Calls fn for every connection currently registered
+            template<typename Fn>
+            void forEach(Fn&& fn) const
+            {
+                uint32_t nSlots = m_nSlotsUsed.load(std::memory_order_acquire);
+                for (uint32_t index = 0; index < nSlots; index++)
+                {
+                    std::shared_ptr<connection<T>> conn = std::atomic_load_explicit(&slotAt(index).conn, std::memory_order_acquire);
+                    if (conn)
+                        fn(conn);
+                }
+            }
+
+            // Number of registered connections
+            size_t size() const
+            {
+                return m_nLive.load(std::memory_order_relaxed);
+            }
+
+        private:
+            static constexpr uint32_t CHUNK_SIZE = 256;
+
+            struct Slot
+            {
+                std::shared_ptr<connection<T>> conn;    // Accessed with the atomic shared_ptr functions
+                std::atomic<uint32_t> id{ 0 };          // ID of the stored connection, 0 while free
+                uint32_t generation = 1;                // Generation of the next ID handed out, 1..MAX_GENERATION (writers only)
+            };
+
+            struct Chunk
+            {
+                std::array<Slot, CHUNK_SIZE> slots;
+            };
+
+            // Only valid for index < m_nSlotsUsed, whose chunk has been published
+            Slot& slotAt(uint32_t index) const
+            {
+                return m_chunks[index / CHUNK_SIZE].load(std::memory_order_acquire)->slots[index % CHUNK_SIZE];
+            }
+
+            std::array<std::atomic<Chunk*>, MAX_SLOTS / CHUNK_SIZE> m_chunks;
+            std::atomic<uint32_t> m_nSlotsUsed{ 0 };    // Slots ever handed out; readers scan [0, m_nSlotsUsed)
+            std::atomic<size_t> m_nLive{ 0 };
+
+            std::mutex m_muxWriters;
+            std::deque<uint32_t> m_freeSlots;           // Removed slots, oldest first (guarded by m_muxWriters)
+        };
+    }
+}
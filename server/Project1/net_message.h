@@ -1,5 +1,6 @@
 #pragma once
 #include "net_common.h"
+#include "net_messageTrace.h"
 
 namespace olc
 {
@@ -9,6 +10,66 @@ namespace olc
         template <typename T>
         class connection;
 
+        // Received bytes held against the server's receive budget (see inbound_budget) by the message
+        // carrying them. They are given back when that message is destroyed, so a body waiting in a worker
+        // queue stays counted until its handler has finished. Moves with the message; copies hold nothing
+        class budget_charge
+        {
+        public:
+            budget_charge() = default;
+
+            budget_charge(std::atomic<size_t>& used, size_t nBytes)
+                : m_pUsed(&used), m_nBytes(nBytes)
+            {
+            }
+
+            budget_charge(const budget_charge&) noexcept
+            {
+            }
+
+            budget_charge(budget_charge&& other) noexcept
+                : m_pUsed(std::exchange(other.m_pUsed, nullptr)), m_nBytes(other.m_nBytes)
+            {
+            }
+
+            budget_charge& operator=(const budget_charge& other) noexcept
+            {
+                if (this != &other)
+                    release();
+                return *this;
+            }
+
+            budget_charge& operator=(budget_charge&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    release();
+                    m_pUsed = std::exchange(other.m_pUsed, nullptr);
+                    m_nBytes = other.m_nBytes;
+                }
+                return *this;
+            }
+
+            ~budget_charge()
+            {
+                release();
+            }
+
+            // Gives the bytes back now instead of at destruction
+            void release()
+            {
+                if (m_pUsed)
+                {
+                    m_pUsed->fetch_sub(m_nBytes, std::memory_order_relaxed);
+                    m_pUsed = nullptr;
+                }
+            }
+
+        private:
+            std::atomic<size_t>* m_pUsed = nullptr;
+            size_t m_nBytes = 0;
+        };
+
         // Message header structure containing message ID and size
         template <typename T>
         struct messageHeader
@@ -23,6 +84,8 @@ namespace olc
         {
             messageHeader<T> header{};
             std::vector<uint8_t> body;
+            trace_ptr trace;    // Stage timestamps, only set on sampled incoming messages
+            budget_charge charge;   // Receive budget held by the body of an incoming message
 
             // Returns total message size (header + body)
             size_t size() const
@@ -77,12 +140,93 @@ namespace olc
                 else
                 {
                     // Handle case when trying to read beyond available data
-                    std::cerr << "Warning: Attempting to read beyond message body!" << std::endl;
+                    LOG_WARN("Warning: Attempting to read beyond message body!");
                 }
 
                 return msg;
             }
 
+
+            // Appends a block of raw bytes to the message body with a single resize
+            void writeBytes(const void* data, size_t size)
+            {
+                size_t i = body.size();
+                body.resize(body.size() + size);
+                if (size > 0)
+                    std::memcpy(body.data() + i, data, size);
+                header.size = static_cast<uint32_t>(this->size());
+            }
+
+            // Extracts a block of raw bytes from the message body, returns false if not enough data
+            bool readBytes(void* data, size_t size)
+            {
+                if (readPos + size > body.size())
+                {
+                    LOG_WARN("Warning: Attempting to read beyond message body!");
+                    return false;
+                }
+
+                if (size > 0)
+                    std::memcpy(data, body.data() + readPos, size);
+                readPos += size;
+                return true;
+            }
+
+            // Appends a string as a uint32_t length prefix followed by its characters
+            void writeString(std::string_view str)
+            {
+                uint32_t length = static_cast<uint32_t>(str.size());
+                size_t i = body.size();
+                body.resize(body.size() + sizeof(uint32_t) + str.size());
+                std::memcpy(body.data() + i, &length, sizeof(uint32_t));
+                if (!str.empty())
+                    std::memcpy(body.data() + i + sizeof(uint32_t), str.data(), str.size());
+                header.size = static_cast<uint32_t>(this->size());
+            }
+
+            // Extracts a length-prefixed string, rejecting lengths above maxSize or beyond the body
+            bool readString(std::string& str, size_t maxSize = SIZE_MAX)
+            {
+                uint32_t length = 0;
+                if (!readBytes(&length, sizeof(uint32_t)))
+                    return false;
+
+                if (length > maxSize || readPos + length > body.size())
+                {
+                    LOG_WARN("Warning: Invalid string length in message body: " << length);
+                    readPos = body.size();
+                    return false;
+                }
+
+                str.assign(reinterpret_cast<const char*>(body.data()) + readPos, length);
+                readPos += length;
+                return true;
+            }
+
+            // Stream operators for length-prefixed strings (preferred over the trivially-copyable template)
+            friend message<T>& operator << (message<T>& msg, std::string_view str)
+            {
+                msg.writeString(str);
+                return msg;
+            }
+
+            friend message<T>& operator << (message<T>& msg, const std::string& str)
+            {
+                msg.writeString(str);
+                return msg;
+            }
+
+            friend message<T>& operator << (message<T>& msg, const char* str)
+            {
+                msg.writeString(str);
+                return msg;
+            }
+
+            friend message<T>& operator >> (message<T>& msg, std::string& str)
+            {
+                msg.readString(str);
+                return msg;
+            }
         };
 
         // Owned message structure for identifying the source connection of a message
@@ -99,5 +243,74 @@ namespace olc
                 return os;
             }
         };
+
+        // How a frame may be treated when the receiving connection cannot keep up
+        enum class frame_delivery
+        {
+            reliable,   // Always delivered (replies, private messages, history)
+            ephemeral   // May be dropped or collapsed while the connection is congested
+        };
+
+        // Immutable pre-serialized message (header followed by body) that can be
+        // queued on any number of connections without copying the body again
+        template <typename T>
+        class frame
+        {
+        public:
+            // collapseKey groups ephemeral frames where only the newest one matters, 0 = none
+            explicit frame(const message<T>& msg, frame_delivery delivery = frame_delivery::reliable, uint32_t collapseKey = 0)
+                : m_id(msg.header.id), m_delivery(delivery), m_collapseKey(collapseKey)
+            {
+                m_bytes.resize(sizeof(messageHeader<T>) + msg.body.size());
+                std::memcpy(m_bytes.data(), &msg.header, sizeof(messageHeader<T>));
+                if (!msg.body.empty())
+                    std::memcpy(m_bytes.data() + sizeof(messageHeader<T>), msg.body.data(), msg.body.size());
+            }
+
+            // Message type of the serialized message
+            T id() const
+            {
+                return m_id;
+            }
+
+            frame_delivery delivery() const
+            {
+                return m_delivery;
+            }
+
+            uint32_t collapseKey() const
+            {
+                return m_collapseKey;
+            }
+
+            // Serialized bytes ready to be written to a socket
+            const uint8_t* data() const
+            {
+                return m_bytes.data();
+            }
+
+            // Total serialized size (header + body)
+            size_t size() const
+            {
+                return m_bytes.size();
+            }
+
+        private:
+            T m_id{};
+            frame_delivery m_delivery = frame_delivery::reliable;
+            uint32_t m_collapseKey = 0;
+            std::vector<uint8_t> m_bytes;
+        };
+
+        // Reference-counted handle to an immutable frame
+        template <typename T>
+        using shared_frame = std::shared_ptr<const frame<T>>;
+
+        // Serializes a message once so it can be shared between many sends
+        template <typename T>
+        shared_frame<T> make_shared_frame(const message<T>& msg, frame_delivery delivery = frame_delivery::reliable, uint32_t collapseKey = 0)
+        {
+            return std::make_shared<const frame<T>>(msg, delivery, collapseKey);
+        }
     }
 }
\ No newline at end of file
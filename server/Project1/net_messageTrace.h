@@ -0,0 +1,115 @@
+#pragma once
+#include "net_common.h"
+
+namespace olc
+{
+    namespace net
+    {
+        // Monotonic timestamps of one sampled message on its way through the server
+        // The connection fills in the receive side, update() the dispatch and the worker the handler.
+        // Frames the handler sends keep a reference until they have been written, so the trace is
+        // complete when the last reference goes: its stages are then added to the Metrics histograms.
+        // A stage is skipped when the message never reached one of its ends (e.g. unhandled types).
+        struct message_trace
+        {
+            using clock = std::chrono::steady_clock;
+
+            clock::time_point headerRead;       // Read that completed the frame header
+            clock::time_point bodyRead;         // Read that completed the frame body
+            clock::time_point enqueued;         // Pushed into the server's incoming queue
+            clock::time_point dispatchStart;    // update() called onMessage
+            clock::time_point dispatchEnd;      // onMessage returned
+            clock::time_point handlerStart;     // Worker started the message's handler
+            clock::time_point handlerEnd;       // Handler returned
+
+            // Latest completion of a write carrying a frame the handler sent, 0 while there is none
+            std::atomic<clock::rep> lastWrite{ 0 };
+
+            message_trace() = default;
+            message_trace(const message_trace&) = delete;
+            message_trace& operator=(const message_trace&) = delete;
+
+            // Called on the connection's strand once a frame attributed to this message has been written
+            void writeCompleted(clock::time_point when)
+            {
+                clock::rep written = when.time_since_epoch().count();
+                clock::rep current = lastWrite.load(std::memory_order_relaxed);
+                while (current < written && !lastWrite.compare_exchange_weak(current, written, std::memory_order_relaxed))
+                {
+                }
+            }
+
+            ~message_trace()
+            {
+                Metrics& metrics = Metrics::instance();
+                metrics.count(Metrics::CounterId::TracedMessages);
+
+                stage(metrics, Metrics::HistogramId::TraceReceive, headerRead, bodyRead);
+                stage(metrics, Metrics::HistogramId::TraceEnqueue, bodyRead, enqueued);
+                stage(metrics, Metrics::HistogramId::TraceIncomingQueue, enqueued, dispatchStart);
+                stage(metrics, Metrics::HistogramId::TraceDispatch, dispatchStart, dispatchEnd);
+                stage(metrics, Metrics::HistogramId::TraceWorkerQueue, dispatchEnd, handlerStart);
+                stage(metrics, Metrics::HistogramId::TraceHandler, handlerStart, handlerEnd);
+
+                clock::time_point finished = std::max({ enqueued, dispatchEnd, handlerEnd });
+                clock::rep written = lastWrite.load(std::memory_order_relaxed);
+                if (written != 0)
+                {
+                    clock::time_point writeDone{ clock::duration(written) };
+                    stage(metrics, Metrics::HistogramId::TraceWrite, handlerEnd, writeDone);
+                    finished = std::max(finished, writeDone);
+                }
+                stage(metrics, Metrics::HistogramId::TraceTotal, headerRead, finished);
+            }
+
+        private:
+            // Stages that overlap (a worker may start the handler before onMessage returns) count as 0
+            static void stage(Metrics& metrics, Metrics::HistogramId id, clock::time_point from, clock::time_point to)
+            {
+                if (from != clock::time_point() && to != clock::time_point())
+                    metrics.record(id, to > from ? to - from : clock::duration::zero());
+            }
+        };
+
+        using trace_ptr = std::shared_ptr<message_trace>;
+
+        // Trace of the message whose handler runs on this thread; connections attach it to the frames sent meanwhile
+        inline trace_ptr& current_trace()
+        {
+            static thread_local trace_ptr trace;
+            return trace;
+        }
+
+        // Times a traced message's handler and attributes the frames it sends to the message
+        // Releases the message's reference at the end, so the trace completes once those frames are written
+        class handler_trace_scope
+        {
+        public:
+            explicit handler_trace_scope(trace_ptr& trace)
+                : m_trace(trace)
+            {
+                if (m_trace)
+                {
+                    m_trace->handlerStart = message_trace::clock::now();
+                    current_trace() = m_trace;
+                }
+            }
+
+            handler_trace_scope(const handler_trace_scope&) = delete;
+            handler_trace_scope& operator=(const handler_trace_scope&) = delete;
+
+            ~handler_trace_scope()
+            {
+                if (m_trace)
+                {
+                    m_trace->handlerEnd = message_trace::clock::now();
+                    current_trace().reset();
+                    m_trace.reset();
+                }
+            }
+
+        private:
+            trace_ptr& m_trace;
+        };
+    }
+}
@@ -0,0 +1,205 @@
+#pragma once
+#include "net_common.h"
+#include <atomic>
+
+namespace olc
+{
+    namespace net
+    {
+        // Lock-free multi-producer/single-consumer queue
+        // Any number of I/O threads may push, but only one thread may pop, wait or clear
+        // Producers only touch the wakeup mutex when the consumer is actually parked
+        // An element count next to the head tells producers how deep the queue was when they pushed
+        template<typename T>
+        class mpscQueue
+        {
+        public:
+            mpscQueue()
+            {
+                m_pHead.store(&m_stub, std::memory_order_relaxed);
+                m_pTail = &m_stub;
+            }
+
+            mpscQueue(const mpscQueue<T>&) = delete;
+            mpscQueue<T>& operator=(const mpscQueue<T>&) = delete;
+
+            ~mpscQueue()
+            {
+                clear();
+            }
+
+            // Adds an element to the back of the queue (copy version)
+            // Returns the number of elements already queued
+            size_t push_back(const T& item)
+            {
+                size_t depth = m_nSize.fetch_add(1, std::memory_order_relaxed);
+                enqueue(new node(item));
+                return depth;
+            }
+
+            // Adds an element to the back of the queue (move version)
+            // Returns the number of elements already queued
+            size_t push_back(T&& item)
+            {
+                size_t depth = m_nSize.fetch_add(1, std::memory_order_relaxed);
+                enqueue(new node(std::move(item)));
+                return depth;
+            }
+
+            // Approximate number of queued elements, may be read from any thread
+            size_t size() const
+            {
+                return m_nSize.load(std::memory_order_relaxed);
+            }
+
+            // Moves the front element into item and removes it, returns false if the queue is empty
+            // Consumer thread only
+            bool try_pop(T& item)
+            {
+                node* tail = m_pTail;
+                node* next = tail->next.load(std::memory_order_acquire);
+
+                // Skip over the stub node
+                if (tail == &m_stub)
+                {
+                    if (next == nullptr)
+                        return false;
+
+                    m_pTail = next;
+                    tail = next;
+                    next = next->next.load(std::memory_order_acquire);
+                }
+
+                if (next != nullptr)
+                {
+                    m_pTail = next;
+                    item = std::move(*tail->value);
+                    delete tail;
+                    m_nSize.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+
+                // A producer has swapped the head but not linked its node yet
+                if (tail != m_pHead.load(std::memory_order_acquire))
+                    return false;
+
+                // Tail is the last node, re-insert the stub behind it so it can be released
+                enqueue(&m_stub, false);
+
+                next = tail->next.load(std::memory_order_acquire);
+                if (next != nullptr)
+                {
+                    m_pTail = next;
+                    item = std::move(*tail->value);
+                    delete tail;
+                    m_nSize.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+
+                return false;
+            }
+
+            // Moves up to maxItems elements onto the back of out, returns the number moved
+            // Consumer thread only
+            size_t drain(std::vector<T>& out, size_t maxItems = SIZE_MAX)
+            {
+                size_t count = 0;
+                T item;
+                while (count < maxItems && try_pop(item))
+                {
+                    out.push_back(std::move(item));
+                    count++;
+                }
+                return count;
+            }
+
+            // Checks if the queue is empty
+            // Consumer thread only
+            bool empty() const
+            {
+                const node* tail = m_pTail;
+                if (tail == &m_stub)
+                    return tail->next.load(std::memory_order_acquire) == nullptr;
+                return false;
+            }
+
+            // Removes all elements from the queue
+            // Consumer thread only
+            void clear()
+            {
+                T item;
+                while (try_pop(item)) {}
+            }
+
+            // Blocks the consumer thread until the queue has at least one element
+            void wait()
+            {
+                if (!empty())
+                    return;
+
+                std::unique_lock<std::mutex> ul(m_muxPark);
+
+                // Announce the intent to sleep before the final emptiness check, so a producer
+                // pushing concurrently either sees the flag or its element is seen here
+                m_bParked.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                m_cvPark.wait(ul, [this] { return !empty(); });
+                m_bParked.store(false, std::memory_order_relaxed);
+            }
+
+            // Blocks the consumer thread until the queue has an element or the timeout expires
+            // Returns false on timeout
+            template<typename Rep, typename Period>
+            bool wait_for(const std::chrono::duration<Rep, Period>& timeout)
+            {
+                if (!empty())
+                    return true;
+
+                std::unique_lock<std::mutex> ul(m_muxPark);
+                m_bParked.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                bool ready = m_cvPark.wait_for(ul, timeout, [this] { return !empty(); });
+                m_bParked.store(false, std::memory_order_relaxed);
+                return ready;
+            }
+
+        private:
+            struct node
+            {
+                node() = default;
+                template<typename U>
+                explicit node(U&& v) : value(std::in_place, std::forward<U>(v)) {}
+
+                std::atomic<node*> next{ nullptr };
+                std::optional<T> value;
+            };
+
+            // Publishes a node at the head of the list
+            void enqueue(node* n, bool wake = true)
+            {
+                n->next.store(nullptr, std::memory_order_relaxed);
+                node* prev = m_pHead.exchange(n, std::memory_order_seq_cst);
+                prev->next.store(n, std::memory_order_release);
+
+                // Wake the consumer only if it is parked
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (wake && m_bParked.load(std::memory_order_relaxed))
+                {
+                    std::lock_guard<std::mutex> lock(m_muxPark);
+                    m_cvPark.notify_one();
+                }
+            }
+
+            // Producers swap the head, the consumer owns the tail
+            alignas(64) std::atomic<node*> m_pHead;
+            std::atomic<size_t> m_nSize{ 0 };
+            alignas(64) node* m_pTail;
+            node m_stub;
+
+            // Parking state for the consumer
+            alignas(64) std::atomic<bool> m_bParked{ false };
+            std::mutex m_muxPark;
+            std::condition_variable m_cvPark;
+        };
+    }
+}
@@ -1,8 +1,10 @@
 #pragma once
 #include "net_common.h"
-#include "net_tsQueue.h"
+#include "net_mpscQueue.h"
 #include "net_message.h"
 #include "net_connection.h"
+#include "net_connectionRegistry.h"
+#include "net_timerWheel.h"
 
 // Enumeration defining custom message types for network communication
 enum class CustomMsgTypes : uint32_t
@@ -27,9 +29,31 @@ enum class CustomMsgTypes : uint32_t
     ChatHistoryResponse,
     GlobalMessage,           // Message for global chat
     GlobalChatHistoryRequest, // Request for global chat history
-    GlobalChatHistoryResponse // Response for global chat history
+    GlobalChatHistoryResponse, // Response for global chat history
+    HistoryChunk,            // One part of a large history response
+    HistoryChunkAck,         // Client has processed a history chunk
+    StatsRequest,            // Admin request for the server statistics report
+    StatsResponse            // Statistics report as one length-prefixed string
 };
 
+// Chat history paging: a ChatHistoryRequest may carry [uint32 beforeSeq][uint32 limit] after the user ID
+// History responses carry binary entries (see history_encoding.h):
+//   ChatHistoryResponse:       [uint32 partner ID][uint32 older cursor, 0 = none][uint32 total][uint32 count][entries]
+//   GlobalChatHistoryResponse: [uint32 count][entries]
+// Responses with more than HISTORY_CHUNK_SIZE bytes of entries are streamed as HistoryChunk frames instead:
+//   [uint32 stream ID][uint32 response type][uint32 chunk index][uint32 chunk count][response body with this chunk's entries]
+// The client answers every chunk with HistoryChunkAck [uint32 stream ID]; at most HISTORY_CHUNK_WINDOW chunks
+// of a stream are unacknowledged at a time
+const size_t HISTORY_CHUNK_SIZE = 16 * 1024;
+const uint32_t HISTORY_CHUNK_WINDOW = 4;
+// Largest accepted request contents, enforced on the frame size before the body is read
+const uint32_t MAX_CHAT_TEXT_SIZE = 10000;        // Global and direct message text, the client uses the same limit
+const uint32_t MAX_CREDENTIAL_SIZE = 100;         // Username, password or email
+const uint32_t MAX_CONTROL_BODY_SIZE = 64;        // Requests carrying only a few IDs
+const uint32_t CHAT_HISTORY_LATEST = UINT32_MAX;  // Cursor value asking for the newest page
+const uint32_t CHAT_HISTORY_PAGE_SIZE = 50;       // Messages per page when the request names no limit
+const uint32_t CHAT_HISTORY_MAX_PAGE_SIZE = 200;  // Upper bound on a requested limit
+
 namespace olc
 {
     namespace net
@@ -40,19 +64,18 @@ namespace olc
         {
         public:
             // Utility method to find a client by their unique ID
-            std::shared_ptr<olc::net::connection<CustomMsgTypes>> getClientByID(uint32_t id) {
-                for (auto& client : getAllClients()) {
-                    if (client && client->getID() == id) {
-                        return client;
-                    }
-                }
-                return nullptr;
+            // O(1) and lock-free; the ID of a removed client resolves to nullptr even after its slot is reused
+            std::shared_ptr<connection<T>> getClientByID(uint32_t id) {
+                return m_connections.find(id);
             }
 
-            // Constructor: Initialize server with specified port
-            server_interface(uint16_t port)
-                : m_asioAcceptor(m_asioContext, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port))
+            // Constructor: Initialize server with specified port and number of I/O threads
+            // nIoThreads = 0 uses one thread per hardware core
+            server_interface(uint16_t port, size_t nIoThreads = 0)
+                : m_asioAcceptor(m_asioContext, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port)),
+                m_timers(m_asioContext)
             {
+                m_nIoThreads = nIoThreads > 0 ? nIoThreads : std::max<size_t>(1, std::thread::hardware_concurrency());
             }
 
             // Destructor: Ensure proper cleanup when server is destroyed
@@ -64,7 +87,7 @@ namespace olc
             // Virtual method called when a client is validated and ready to communicate
             virtual void onClientValidated(std::shared_ptr<connection<T>> client)
             {
-                std::cout << "[SERVER] Client " << client->getID() << " validated" << std::endl;
+                LOG_INFO("[SERVER] Client " << client->getID() << " validated");
             }
 
             // Start the server and begin accepting client connections
@@ -75,39 +98,170 @@ namespace olc
                     // Begin waiting for client connections
                     waitForClientConnection();
 
-                    // Start ASIO context in a separate thread
-                    m_threadContext = std::thread([this]() { m_asioContext.run(); });
+                    // Heartbeats, idle timeouts and deferred disconnects all run on the timer wheel
+                    m_timers.start();
+                    if (m_metricsInterval.count() > 0)
+                        scheduleMetricsReport();
+
+                    // Run the ASIO context on a pool of I/O threads
+                    // Each connection's handlers are serialized on its own strand
+                    for (size_t i = 0; i < m_nIoThreads; i++)
+                    {
+                        m_vThreadPool.emplace_back([this]() { m_asioContext.run(); });
+                    }
                 }
                 catch (std::exception& e)
                 {
-                    std::cerr << "[SERVER] Exception: " << e.what() << "\n";
+                    LOG_ERROR("[SERVER] Exception: " << e.what());
                     return false;
                 }
 
-                std::cout << "[SERVER] Started!\n";
+                LOG_INFO("[SERVER] Started with " << m_nIoThreads << " I/O thread(s)!");
                 return true;
             }
 
+            // Sets the outgoing queue limits and slow-consumer policy applied to connections accepted from now on
+            void setOutboundLimits(const outbound_limits& limits)
+            {
+                std::lock_guard<std::mutex> lock(m_muxOutboundLimits);
+                m_outboundLimits = limits;
+            }
+
+            // Sets how often idle clients are pinged and after how long without any data they are dropped
+            // Call before start()
+            void setHeartbeat(std::chrono::milliseconds interval, std::chrono::milliseconds idleTimeout)
+            {
+                m_heartbeatInterval = interval;
+                m_idleTimeout = idleTimeout;
+            }
+
+            // Number of clients dropped for not sending anything within the idle timeout
+            uint64_t reapedConnections() const
+            {
+                return m_nReapedConnections.load(std::memory_order_relaxed);
+            }
+
+            // Logs statsReport() every interval (0 = never); typeName labels message types in reports
+            // Call before start()
+            void setMetricsReport(std::chrono::milliseconds interval, std::function<std::string(uint32_t)> typeName)
+            {
+                m_metricsInterval = interval;
+                m_metricsTypeName = std::move(typeName);
+            }
+
+            // Text report of the process metrics plus this server's queues, limits and connection counters
+            std::string statsReport()
+            {
+                Metrics::Snapshot snapshot = Metrics::instance().snapshot();
+                std::ostringstream out;
+                out << Metrics::format(snapshot, m_metricsTypeName);
+
+                out << "Incoming queue: " << m_qMessagesIn.size() << " messages waiting\n";
+
+                size_t nFrames = 0, nBytes = 0, nDeepest = 0;
+                uint32_t deepestID = 0;
+                m_connections.forEach([&](const std::shared_ptr<connection<T>>& client) {
+                    size_t frames = client->outboundFrames();
+                    nFrames += frames;
+                    nBytes += client->outboundBytes();
+                    if (frames > nDeepest)
+                    {
+                        nDeepest = frames;
+                        deepestID = client->getID();
+                    }
+                    });
+                out << "Connections: " << m_connections.size() << ", outgoing queues hold " << nFrames << " frames / "
+                    << nBytes << " bytes";
+                if (nDeepest > 0)
+                    out << ", deepest " << nDeepest << " frames (client " << deepestID << ")";
+                out << "\n";
+
+                out << "Slow consumers: " << m_outboundCounters.congestions.load(std::memory_order_relaxed) << " congestions, "
+                    << m_outboundCounters.dropped.load(std::memory_order_relaxed) << " frames dropped, "
+                    << m_outboundCounters.collapsed.load(std::memory_order_relaxed) << " collapsed, "
+                    << m_outboundCounters.disconnects.load(std::memory_order_relaxed) << " disconnected\n";
+                out << "Receive budget: " << m_inboundBudget.used.load(std::memory_order_relaxed) << " of " << m_inboundBudget.capacity
+                    << " bytes, " << m_inboundBudget.oversizedFrames.load(std::memory_order_relaxed) << " oversized frames, "
+                    << m_inboundBudget.deferredReads.load(std::memory_order_relaxed) << " deferred reads, "
+                    << m_inboundBudget.refusedConnections.load(std::memory_order_relaxed) << " refused connections\n";
+                out << "Idle connections reaped: " << reapedConnections() << ", log lines dropped: " << Logger::instance().dropped() << "\n";
+                return out.str();
+            }
+
+            // Removes a client after a delay without blocking the caller
+            // The ID is resolved when the timer fires, so a client that is already gone is left alone
+            void removeClientAfter(uint32_t clientID, std::chrono::milliseconds delay)
+            {
+                m_timers.schedule(delay, [this, clientID]() {
+                    auto client = getClientByID(clientID);
+                    if (client) {
+                        notifyConnectionClosed(client);
+                    }
+                    });
+            }
+
+            // Traces one in every oneIn incoming messages through read, queueing, dispatch, handling and the
+            // writes it causes (0 = none); see message_trace. Applies to connections accepted from now on
+            void setTraceSampling(uint32_t oneIn)
+            {
+                m_nTraceSampling = oneIn;
+            }
+
+            // Sets the largest accepted frame (header + body) for a message type; other types are limited
+            // to inbound_limits::defaultMaxFrameSize. Call before start()
+            void setMaxFrameSize(T type, uint32_t nBytes)
+            {
+                size_t index = static_cast<size_t>(type);
+                if (m_inboundLimits.maxFrameSize.size() <= index)
+                    m_inboundLimits.maxFrameSize.resize(index + 1, 0);
+                m_inboundLimits.maxFrameSize[index] = nBytes;
+            }
+
+            // Sets how many received bytes all connections may buffer together. Call before start()
+            void setInboundBudget(size_t nBytes)
+            {
+                m_inboundBudget.capacity = nBytes;
+            }
+
+            // Receive budget usage and how often it limited clients
+            const inbound_budget& inboundBudget() const
+            {
+                return m_inboundBudget;
+            }
+
+            // How often the slow-consumer policy fired across all connections
+            const outbound_counters& outboundCounters() const
+            {
+                return m_outboundCounters;
+            }
+
             // Stop the server and clean up resources
             void stop()
             {
                 // Stop ASIO context
                 m_asioContext.stop();
 
-                // Wait for context thread to finish
-                if (m_threadContext.joinable())
-                    m_threadContext.join();
+                // Wait for all I/O threads to finish
+                for (auto& thread : m_vThreadPool)
+                {
+                    if (thread.joinable())
+                        thread.join();
+                }
+                m_vThreadPool.clear();
 
-                std::cout << "[SERVER] Stopped!\n";
+                LOG_INFO("[SERVER] Stopped!");
             }
 
         public:
             // Method to safely remove a client from the server
+            // Only the first removal of a connection runs the disconnect handler
+            // Dispatch thread only: other threads hand the client to notifyConnectionClosed instead
             void removeClient(std::shared_ptr<connection<T>> client)
             {
-                if (client)
+                if (client && m_connections.remove(client->getID(), client))
                 {
-                    std::cout << "[SERVER] Removing client: ID=" << client->getID() << std::endl;
+                    LOG_INFO("[SERVER] Removing client: ID=" << client->getID());
+                    client->markRemoved();
 
                     // Call disconnect handler before removing
                     onClientDisconnect(client);
@@ -115,28 +269,27 @@ namespace olc
                     // Disconnect the client
                     client->disconnect();
 
-                    // Remove client from the connections list
-                    m_deqConnections.erase(
-                        std::remove_if(m_deqConnections.begin(), m_deqConnections.end(),
-                            [&client](const std::shared_ptr<connection<T>>& conn) {
-                                return conn == client || !conn || !conn->isConnected();
-                            }),
-                        m_deqConnections.end());
-
                     // Log current number of active connections
-                    std::cout << "[SERVER] Active connections remaining: " << m_deqConnections.size() << std::endl;
+                    LOG_INFO("[SERVER] Active connections remaining: " << m_connections.size());
                 }
             }
 
             // ASYNC - Start listening for new client connections
             void waitForClientConnection()
             {
-                m_asioAcceptor.async_accept(
+                // Every accepted socket gets its own strand as its executor
+                m_asioAcceptor.async_accept(boost::asio::make_strand(m_asioContext),
                     [this](boost::system::error_code ec, boost::asio::ip::tcp::socket socket)
                     {
-                        if (!ec)
+                        if (!ec && !m_inboundBudget.canAdmit(connection<T>::RECEIVE_CHUNK_SIZE))
+                        {
+                            // Admission control: no new receive buffers while the budget is used up
+                            m_inboundBudget.refusedConnections.fetch_add(1, std::memory_order_relaxed);
+                            LOG_WARN("[-----] Connection Denied (receive budget exhausted)");
+                        }
+                        else if (!ec)
                         {
-                            std::cout << "[SERVER] New Connection: " << socket.remote_endpoint() << "\n";
+                            LOG_INFO("[SERVER] New Connection: " << socket.remote_endpoint());
 
                             // Create new connection object
                             std::shared_ptr<connection<T>> newconn =
@@ -148,21 +301,36 @@ namespace olc
                             // Check if connection should be accepted
                             if (onClientConnect(newconn))
                             {
-                                m_deqConnections.push_back(std::move(newconn));
-
-                                // Start reading messages from the new client
-                                m_deqConnections.back()->connectToClient(this, nIDCounter++);
-
-                                std::cout << "[" << m_deqConnections.back()->getID() << "] Connection Approved\n";
+                                {
+                                    std::lock_guard<std::mutex> lock(m_muxOutboundLimits);
+                                    newconn->setOutboundLimits(m_outboundLimits, &m_outboundCounters);
+                                }
+                                newconn->setInboundLimits(m_inboundLimits, &m_inboundBudget);
+                                newconn->setTraceSampling(m_nTraceSampling);
+
+                                // The registry slot decides the client's ID
+                                uint32_t nID = m_connections.insert(newconn);
+                                if (nID != 0)
+                                {
+                                    // Start reading messages from the new client
+                                    newconn->connectToClient(this, nID);
+                                    scheduleHeartbeat(newconn);
+
+                                    LOG_INFO("[" << newconn->getID() << "] Connection Approved");
+                                }
+                                else
+                                {
+                                    LOG_WARN("[-----] Connection Denied (connection registry full)");
+                                }
                             }
                             else
                             {
-                                std::cout << "[-----] Connection Denied\n";
+                                LOG_INFO("[-----] Connection Denied");
                             }
                         }
                         else
                         {
-                            std::cerr << "[SERVER] New Connection Error: " << ec.message() << "\n";
+                            LOG_ERROR("[SERVER] New Connection Error: " << ec.message());
                         }
 
                         // Continue listening for more connections recursively
@@ -177,24 +345,45 @@ namespace olc
                 {
                     client->send(msg);
                 }
-                else
+                else if (client)
+                {
+                    // Remove client if connection is invalid
+                    notifyConnectionClosed(client);
+                }
+            }
+
+            // Send a pre-serialized frame to a specific client with connection validation
+            void messageClient(std::shared_ptr<connection<T>> client, shared_frame<T> frame)
+            {
+                if (client && client->isConnected())
+                {
+                    client->send(std::move(frame));
+                }
+                else if (client)
                 {
                     // Remove client if connection is invalid
-                    removeClient(client);
+                    notifyConnectionClosed(client);
                 }
             }
 
             // Broadcast a message to all connected clients with optional exclusion
+            // The message is serialized once and the same frame is shared by every recipient
             void messageAllClients(const message<T>& msg, std::shared_ptr<connection<T>> pIgnoreClient = nullptr)
+            {
+                messageAllClients(make_shared_frame(msg), pIgnoreClient);
+            }
+
+            // Broadcast a pre-serialized frame to all connected clients with optional exclusion
+            void messageAllClients(const shared_frame<T>& frame, std::shared_ptr<connection<T>> pIgnoreClient = nullptr)
             {
                 std::vector<std::shared_ptr<connection<T>>> invalidClients;
 
-                for (auto& client : m_deqConnections)
+                for (auto& client : getAllClients())
                 {
                     if (client && client->isConnected())
                     {
                         if (client != pIgnoreClient)
-                            client->send(msg);
+                            client->send(frame);
                     }
                     else
                     {
@@ -206,44 +395,133 @@ namespace olc
                 // Remove all invalid connections
                 for (auto& client : invalidClients)
                 {
-                    removeClient(client);
+                    notifyConnectionClosed(client);
                 }
             }
 
+            // Called from any thread when a client's connection has closed or must be dropped
+            // The client is removed by the next update() on the dispatch thread; a message without a
+            // remote wakes update() in case it is parked on the empty incoming queue
+            void notifyConnectionClosed(std::shared_ptr<connection<T>> client)
+            {
+                m_qClosedConnections.push_back(std::move(client));
+                m_qMessagesIn.push_back(owned_message<T>());
+            }
+
             // Process incoming messages from the message queue
-            void update(size_t maxMessages = -1, bool wait = false)
+            // Drains up to maxMessages in one pass and dispatches them; blocks only when the queue is empty
+            // Returns the number of messages dispatched
+            size_t update(size_t maxMessages = -1, bool wait = false)
             {
-                if (wait && m_qMessagesIn.empty())
+                if (wait)
                 {
                     // Wait for messages if queue is empty and wait flag is set
                     m_qMessagesIn.wait();
                 }
 
-                size_t messageCount = 0;
-                while (messageCount < maxMessages && !m_qMessagesIn.empty())
+                // Move the pending messages into the reusable batch, then dispatch without touching the queue
+                m_vDispatchBatch.clear();
+                m_qMessagesIn.drain(m_vDispatchBatch, maxMessages);
+
+                // Drop the wake-ups of notifyConnectionClosed; each was pushed after its connection, so every
+                // connection whose wake-up was drained is released below
+                m_vDispatchBatch.erase(std::remove_if(m_vDispatchBatch.begin(), m_vDispatchBatch.end(),
+                    [](const owned_message<T>& msg) { return !msg.remote; }), m_vDispatchBatch.end());
+
+                // Release the slots of connections that closed since the last pass
+                std::shared_ptr<connection<T>> closed;
+                while (m_qClosedConnections.try_pop(closed))
+                {
+                    removeClient(closed);
+                }
+
+                size_t messageCount = m_vDispatchBatch.size();
+                if (messageCount > 0)
+                {
+                    Metrics::instance().count(Metrics::CounterId::Dispatched, messageCount);
+                    Metrics::instance().record(Metrics::HistogramId::DispatchBatch, messageCount);
+                }
+
+                // A message's body stays in the receive budget until the message is destroyed: here for
+                // messages onMessage does not keep, or wherever it moved them once they have been handled
+                for (auto& msg : m_vDispatchBatch)
                 {
-                    // Get message from front of queue
-                    auto msg = m_qMessagesIn.front();
-                    m_qMessagesIn.pop_front();
+                    // onMessage may move the message away, keep the trace to stamp the end of dispatch
+                    trace_ptr trace = msg.msg.trace;
+                    if (trace)
+                        trace->dispatchStart = message_trace::clock::now();
 
                     // Process the message
                     onMessage(msg.remote, msg.msg);
 
-                    messageCount++;
+                    if (trace)
+                        trace->dispatchEnd = message_trace::clock::now();
                 }
+
+                m_vDispatchBatch.clear();
+                return messageCount;
+            }
+
+            // Get a snapshot of all connected clients (safe to iterate while I/O threads add connections)
+            std::deque<std::shared_ptr<connection<T>>> getAllClients()
+            {
+                std::deque<std::shared_ptr<connection<T>>> clients;
+                m_connections.forEach([&clients](const std::shared_ptr<connection<T>>& client) {
+                    clients.push_back(client);
+                    });
+                return clients;
+            }
+
+        private:
+            // Checks a client once per heartbeat interval: pings it when it has been quiet for an interval
+            // and drops it once nothing arrived within the idle timeout. Half-open connections therefore
+            // go away within idleTimeout + one interval. The timer holds only a weak reference
+            void scheduleHeartbeat(const std::shared_ptr<connection<T>>& client)
+            {
+                std::weak_ptr<connection<T>> weakClient = client;
+                m_timers.schedule(m_heartbeatInterval, [this, weakClient]() {
+                    auto client = weakClient.lock();
+                    if (!client || !client->isConnected())
+                        return;
+
+                    auto idle = std::chrono::steady_clock::now() - client->lastReceived();
+                    if (idle >= m_idleTimeout)
+                    {
+                        m_nReapedConnections.fetch_add(1, std::memory_order_relaxed);
+                        LOG_INFO("[SERVER] Client " << client->getID() << " idle for "
+                            << std::chrono::duration_cast<std::chrono::seconds>(idle).count() << "s, disconnecting");
+                        notifyConnectionClosed(client);
+                        return;
+                    }
+
+                    if (idle >= m_heartbeatInterval)
+                    {
+                        // The client echoes the ping; any data it sends counts as a sign of life
+                        message<T> ping;
+                        ping.header.id = T::ServerPing;
+                        ping << uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::system_clock::now().time_since_epoch()).count());
+                        client->send(ping);
+                    }
+
+                    scheduleHeartbeat(client);
+                    });
             }
 
-            // Get reference to all connected clients (used by CustomServer::getClientByID)
-            std::deque<std::shared_ptr<connection<T>>>& getAllClients()
+            // Logs the statistics report once per metrics interval
+            void scheduleMetricsReport()
             {
-                return m_deqConnections;
+                m_timers.schedule(m_metricsInterval, [this]() {
+                    LOG_INFO("[METRICS] Server statistics\n" << statsReport());
+                    scheduleMetricsReport();
+                    });
             }
 
         protected:
             // Virtual methods that should be overridden by derived classes
 
             // Called when a new client attempts to connect - return true to accept
-            virtual bool onClientConnect(std::shared_ptr<connection<T>> client)
+            virtual bool onClientConnect([[maybe_unused]] std::shared_ptr<connection<T>> client)
             {
                 return false;
             }
@@ -259,21 +537,50 @@ namespace olc
             }
 
         protected:
-            // Thread-safe queue for incoming messages from clients
-            tsQueue<owned_message<T>> m_qMessagesIn;
+            // Incoming frame size limits given to new connections and the receive budget they share
+            // Declared before the queues and the ASIO context: queued messages and connections still owned by
+            // its handlers release into the budget when they are destroyed
+            inbound_limits m_inboundLimits;
+            inbound_budget m_inboundBudget;
 
-            // ASIO context for handling I/O operations
+            // Lock-free queue for incoming messages, filled by the I/O threads and drained by update()
+            mpscQueue<owned_message<T>> m_qMessagesIn;
+
+            // Connections closed by their peer or by an error, waiting for removal in update()
+            mpscQueue<std::shared_ptr<connection<T>>> m_qClosedConnections;
+
+            // Messages taken from m_qMessagesIn for the current update() pass, capacity is reused
+            std::vector<owned_message<T>> m_vDispatchBatch;
+
+            // ASIO context for handling I/O operations, run by a pool of threads
             boost::asio::io_context m_asioContext;
-            std::thread m_threadContext;
+            std::vector<std::thread> m_vThreadPool;
+            size_t m_nIoThreads = 1;
 
             // TCP acceptor for listening to new connections
             boost::asio::ip::tcp::acceptor m_asioAcceptor;
 
-            // Container storing all active client connections
-            std::deque<std::shared_ptr<connection<T>>> m_deqConnections;
+            // All active client connections, keyed by their generational client IDs
+            // Added on I/O threads (accept), removed on the dispatch and worker threads, read anywhere without locking
+            connectionRegistry<T> m_connections;
+
+            // Scheduler for heartbeats and deferred work; declared after the ASIO context it runs on
+            timerWheel m_timers;
+            std::chrono::milliseconds m_heartbeatInterval{ 15000 };
+            std::chrono::milliseconds m_idleTimeout{ 45000 };
+            std::atomic<uint64_t> m_nReapedConnections{ 0 };
+
+            // One in how many incoming messages is traced (0 = none, the default)
+            std::atomic<uint32_t> m_nTraceSampling{ 0 };
+
+            // Periodic statistics report and the message type names it uses
+            std::chrono::milliseconds m_metricsInterval{ 0 };
+            std::function<std::string(uint32_t)> m_metricsTypeName;
 
-            // Counter for assigning unique IDs to clients
-            uint32_t nIDCounter = 10000;
+            // Outgoing queue limits given to new connections (guarded by m_muxOutboundLimits) and their counters
+            outbound_limits m_outboundLimits;
+            std::mutex m_muxOutboundLimits;
+            outbound_counters m_outboundCounters;
         };
     }
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 #pragma once
 #include "net_server.h"
+#include "dm_log.h"
+#include "history_cache.h"
+#include "history_encoding.h"
 #include <mutex>
 #include <fstream>
 #include <chrono>
@@ -14,25 +17,23 @@ namespace olc
         {
         protected:
             std::mutex chatLogMutex; // Mutex for thread-safe access to chat log files
+            DirectMessageLog directMessageLog; // Append-only per-conversation message logs (guarded by chatLogMutex, except readPage)
+            HistoryCache historyCache; // Encoded newest messages of recently viewed conversations (guarded by chatLogMutex)
 
-        public:
-            // Method to extract only messages from full chat history without timestamps and metadata
-            std::string extractMessagesOnly(const std::string& fullChatHistory);
-
-            // Generates unique chat file name for communication between two specific users
-            std::string generateChatFileName(const std::string& user1, const std::string& user2);
+            // Encodes one message as a binary history entry
+            static std::string encodeChatEntry(const ChatRecord& record);
 
-            // Method to load existing chat history between two users from persistent storage
-            std::string loadChatHistory(const std::string& user1, const std::string& user2);
+        public:
+            // Method to load one page of chat history between two users as encoded history entries
+            // Returns false if the history could not be read
+            bool loadChatHistory(const std::string& user1, const std::string& user2,
+                uint32_t beforeSeq, uint32_t limit, HistoryPage& page);
 
             // Helper method to send a message to a specific client connection
             void SendMessageToClient(std::shared_ptr<olc::net::connection<CustomMsgTypes>> client, const std::string& message);
 
             // Helper method to broadcast a message to all connected clients except the excluded one
             void BroadcastMessage(const std::string& message, std::shared_ptr<olc::net::connection<CustomMsgTypes>> excludeClient = nullptr);
-
-            // Method to extract only messages from global chat history without timestamps and metadata
-            std::string extractGlobalMessagesOnly(const std::string& fullGlobalHistory);
         };
     }
 }
\ No newline at end of file
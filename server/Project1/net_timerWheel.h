@@ -0,0 +1,181 @@
+#pragma once
+#include "net_common.h"
+#include <array>
+#include <functional>
+#include <unordered_map>
+
+namespace olc
+{
+    namespace net
+    {
+        // Hierarchical timer wheel driven by a single steady_timer on the ASIO context
+        // Level 0 has one slot per tick; each higher level covers SLOTS times the range of the one below,
+        // and its slots are cascaded down as time reaches them. Scheduling and cancelling are O(1), and
+        // a tick only touches the timers that are due (or cascading), however many timers exist.
+        // schedule() and cancel() may be called from any thread. Callbacks run on an I/O thread, one at a
+        // time, and should be short: they must not block the context.
+        class timerWheel
+        {
+        public:
+            using timer_id = uint64_t;
+            using callback = std::function<void()>;
+
+            static constexpr size_t LEVEL_BITS = 6;
+            static constexpr size_t SLOTS = size_t(1) << LEVEL_BITS;
+            static constexpr size_t LEVELS = 4;   // 64^4 ticks, about 9 days at 50 ms
+
+            timerWheel(boost::asio::io_context& asioContext, std::chrono::milliseconds tick = std::chrono::milliseconds(50))
+                : m_timer(boost::asio::make_strand(asioContext)), m_tick(tick)
+            {
+            }
+
+            timerWheel(const timerWheel&) = delete;
+            timerWheel& operator=(const timerWheel&) = delete;
+
+            // Starts ticking; timers scheduled before start() count from here
+            void start()
+            {
+                boost::asio::post(m_timer.get_executor(), [this]()
+                    {
+                        m_nextTick = std::chrono::steady_clock::now() + m_tick;
+                        waitForTick();
+                    });
+            }
+
+            // Runs fn once after delay (rounded up to whole ticks, at least one)
+            timer_id schedule(std::chrono::milliseconds delay, callback fn)
+            {
+                uint64_t nTicks = std::max<uint64_t>(1, uint64_t((delay + m_tick - std::chrono::milliseconds(1)) / m_tick));
+
+                std::lock_guard<std::mutex> lock(m_muxTimers);
+                timer_id id = m_nNextID++;
+                uint64_t expiry = m_nCurrentTick + nTicks;
+                m_timers.emplace(id, Timer{ expiry, std::move(fn) });
+                place(id, expiry);
+                return id;
+            }
+
+            // Cancels a timer that has not fired yet; returns false if it already ran or was cancelled
+            // Its slot entry is dropped lazily when the wheel reaches it
+            bool cancel(timer_id id)
+            {
+                std::lock_guard<std::mutex> lock(m_muxTimers);
+                return m_timers.erase(id) > 0;
+            }
+
+            // Number of pending timers
+            size_t size()
+            {
+                std::lock_guard<std::mutex> lock(m_muxTimers);
+                return m_timers.size();
+            }
+
+        private:
+            struct Timer
+            {
+                uint64_t expiry;    // Tick on which the timer fires
+                callback fn;
+            };
+
+            // Puts a timer in the slot of the lowest level whose range covers its distance. Caller holds m_muxTimers
+            void place(timer_id id, uint64_t expiry)
+            {
+                uint64_t distance = expiry > m_nCurrentTick ? expiry - m_nCurrentTick : 0;
+                size_t level = 0;
+                while (level + 1 < LEVELS && distance >= (uint64_t(1) << (LEVEL_BITS * (level + 1))))
+                    level++;
+
+                // Beyond the top level the timer waits in its last slot and is re-placed when cascaded
+                size_t slot = size_t(expiry >> (LEVEL_BITS * level)) & (SLOTS - 1);
+                m_wheel[level][slot].push_back(id);
+            }
+
+            void waitForTick()
+            {
+                m_timer.expires_at(m_nextTick);
+                m_timer.async_wait([this](boost::system::error_code ec)
+                    {
+                        if (ec)
+                            return;
+
+                        // Catch up on ticks missed while the context was busy, without drifting
+                        auto now = std::chrono::steady_clock::now();
+                        while (m_nextTick <= now)
+                        {
+                            advance();
+                            m_nextTick += m_tick;
+                        }
+                        waitForTick();
+                    });
+            }
+
+            // Moves the wheel one tick forward and runs the timers due on it
+            void advance()
+            {
+                std::vector<callback> due;
+                {
+                    std::lock_guard<std::mutex> lock(m_muxTimers);
+                    m_nCurrentTick++;
+
+                    // When a level wraps, its next slot one level up is redistributed (highest level first)
+                    size_t wrapped = 0;
+                    while (wrapped + 1 < LEVELS && ((m_nCurrentTick >> (LEVEL_BITS * (wrapped + 1))) << (LEVEL_BITS * (wrapped + 1))) == m_nCurrentTick)
+                        wrapped++;
+                    for (size_t level = wrapped; level > 0; level--)
+                    {
+                        size_t slot = size_t(m_nCurrentTick >> (LEVEL_BITS * level)) & (SLOTS - 1);
+                        std::vector<timer_id> cascading;
+                        cascading.swap(m_wheel[level][slot]);
+                        for (timer_id id : cascading)
+                        {
+                            auto it = m_timers.find(id);
+                            if (it != m_timers.end())
+                                place(id, it->second.expiry);
+                        }
+                    }
+
+                    std::vector<timer_id>& slot = m_wheel[0][size_t(m_nCurrentTick) & (SLOTS - 1)];
+                    std::vector<timer_id> pending;
+                    pending.swap(slot);
+                    for (timer_id id : pending)
+                    {
+                        auto it = m_timers.find(id);
+                        if (it == m_timers.end())
+                            continue; // Cancelled
+
+                        if (it->second.expiry <= m_nCurrentTick)
+                        {
+                            due.push_back(std::move(it->second.fn));
+                            m_timers.erase(it);
+                        }
+                        else
+                        {
+                            place(id, it->second.expiry);
+                        }
+                    }
+                }
+
+                // Callbacks may schedule or cancel timers, so they run without the lock
+                for (auto& fn : due)
+                {
+                    try {
+                        fn();
+                    }
+                    catch (const std::exception& e) {
+                        LOG_ERROR("[TIMER] Timer callback failed: " << e.what());
+                    }
+                }
+            }
+
+            boost::asio::steady_timer m_timer;
+            std::chrono::milliseconds m_tick;
+            std::chrono::steady_clock::time_point m_nextTick;   // Only touched on the timer's strand
+
+            std::mutex m_muxTimers;
+            uint64_t m_nCurrentTick = 0;
+            timer_id m_nNextID = 1;
+            std::unordered_map<timer_id, Timer> m_timers;       // Pending timers; slot entries without one were cancelled
+            std::array<std::array<std::vector<timer_id>, SLOTS>, LEVELS> m_wheel;
+        };
+    }
+}
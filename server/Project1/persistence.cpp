@@ -0,0 +1,202 @@
+#include "persistence.h"
+#include <future>
+#include <memory>
+#include "logger.h"
+#include "metrics.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Upper bound on cached file handles; the cache is emptied when it is exceeded
+    const size_t MAX_OPEN_FILES = 64;
+
+    // Forces a file's written data to stable storage
+    bool syncFile(std::FILE* file)
+    {
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+}
+
+PersistenceStage::PersistenceStage(FsyncPolicy policy, uint32_t syncIntervalMs)
+    : fsyncPolicy(policy), syncInterval(syncIntervalMs), lastSync(std::chrono::steady_clock::now())
+{
+    writerThread = std::thread([this]() { run(); });
+}
+
+PersistenceStage::~PersistenceStage()
+{
+    Record stop;
+    stop.stop = true;
+    queue.push_back(std::move(stop));
+
+    if (writerThread.joinable())
+        writerThread.join();
+}
+
+void PersistenceStage::append(const std::string& path, std::string bytes, DurableCallback onDurable)
+{
+    Record record;
+    record.path = path;
+    record.bytes = std::move(bytes);
+    record.onDurable = std::move(onDurable);
+    queue.push_back(std::move(record));
+}
+
+void PersistenceStage::flush()
+{
+    auto written = std::make_shared<std::promise<void>>();
+    std::future<void> done = written->get_future();
+
+    Record barrier;
+    barrier.onDurable = [written](bool) { written->set_value(); };
+    queue.push_back(std::move(barrier));
+
+    done.wait();
+}
+
+void PersistenceStage::run()
+{
+    std::vector<Record> batch;
+    std::vector<std::pair<std::string, std::string>> fileWrites;
+    std::unordered_map<std::string, size_t> fileIndex;
+    std::vector<DurableCallback> barriers;
+
+    bool stopping = false;
+    while (!stopping) {
+        // Sleep until work arrives, or until the next interval sync is due
+        if (fsyncPolicy == FsyncPolicy::Interval && (!pendingAcks.empty() || !dirtyFiles.empty())) {
+            auto due = lastSync + syncInterval;
+            auto now = std::chrono::steady_clock::now();
+            if (due > now)
+                queue.wait_for(due - now);
+        }
+        else {
+            queue.wait();
+        }
+
+        batch.clear();
+        queue.drain(batch);
+
+        // Gather the batch into one buffer per file, keeping each file's append order
+        fileWrites.clear();
+        fileIndex.clear();
+        for (Record& record : batch) {
+            if (record.stop) {
+                stopping = true;
+                continue;
+            }
+            if (record.path.empty()) {
+                barriers.push_back(std::move(record.onDurable));
+                continue;
+            }
+
+            auto it = fileIndex.find(record.path);
+            if (it == fileIndex.end()) {
+                it = fileIndex.emplace(record.path, fileWrites.size()).first;
+                fileWrites.emplace_back(record.path, std::string());
+            }
+            fileWrites[it->second].second += record.bytes;
+            Metrics::instance().count(Metrics::CounterId::PersistenceRecords);
+            Metrics::instance().count(Metrics::CounterId::PersistenceBytes, record.bytes.size());
+
+            if (record.onDurable)
+                pendingAcks.push_back({ record.path, std::move(record.onDurable) });
+        }
+
+        if (!fileWrites.empty()) {
+            auto writeStarted = std::chrono::steady_clock::now();
+            for (auto& write : fileWrites) {
+                bool ok = writeFile(write.first, write.second);
+                auto dirty = dirtyFiles.emplace(write.first, ok);
+                if (!ok)
+                    dirty.first->second = false;
+            }
+            Metrics::instance().count(Metrics::CounterId::PersistenceBatches);
+            Metrics::instance().record(Metrics::HistogramId::PersistenceWrite, std::chrono::steady_clock::now() - writeStarted);
+        }
+
+        // Barriers only wait for the data to reach the files
+        for (auto& barrier : barriers)
+            barrier(true);
+        barriers.clear();
+
+        bool syncDue = fsyncPolicy != FsyncPolicy::Interval || stopping ||
+            std::chrono::steady_clock::now() - lastSync >= syncInterval;
+        if (syncDue && (!dirtyFiles.empty() || !pendingAcks.empty()))
+            syncAndAcknowledge();
+    }
+
+    closeFiles();
+}
+
+bool PersistenceStage::writeFile(const std::string& path, const std::string& bytes)
+{
+    std::FILE* file = openFile(path);
+    if (!file) {
+        LOG_ERROR("[PERSISTENCE] Failed to open " << path << " for appending");
+        return false;
+    }
+
+    if (std::fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size() || std::fflush(file) != 0) {
+        LOG_ERROR("[PERSISTENCE] Failed to write " << bytes.size() << " bytes to " << path);
+        std::fclose(file);
+        openFiles.erase(path);
+        return false;
+    }
+    return true;
+}
+
+void PersistenceStage::syncAndAcknowledge()
+{
+    if (fsyncPolicy != FsyncPolicy::None && !dirtyFiles.empty()) {
+        auto syncStarted = std::chrono::steady_clock::now();
+        for (auto& dirty : dirtyFiles) {
+            auto it = openFiles.find(dirty.first);
+            if (dirty.second && (it == openFiles.end() || !syncFile(it->second))) {
+                LOG_ERROR("[PERSISTENCE] fsync failed for " << dirty.first);
+                dirty.second = false;
+            }
+        }
+        Metrics::instance().record(Metrics::HistogramId::PersistenceSync, std::chrono::steady_clock::now() - syncStarted);
+    }
+    lastSync = std::chrono::steady_clock::now();
+
+    for (auto& ack : pendingAcks) {
+        auto it = dirtyFiles.find(ack.path);
+        ack.onDurable(it != dirtyFiles.end() && it->second);
+    }
+    pendingAcks.clear();
+    dirtyFiles.clear();
+
+    // Keep the handle cache bounded; handles are only dropped once nothing is awaiting sync
+    if (openFiles.size() > MAX_OPEN_FILES)
+        closeFiles();
+}
+
+std::FILE* PersistenceStage::openFile(const std::string& path)
+{
+    auto it = openFiles.find(path);
+    if (it != openFiles.end())
+        return it->second;
+
+    std::FILE* file = std::fopen(path.c_str(), "ab");
+    if (file)
+        openFiles.emplace(path, file);
+    return file;
+}
+
+void PersistenceStage::closeFiles()
+{
+    for (auto& file : openFiles)
+        std::fclose(file.second);
+    openFiles.clear();
+}
@@ -0,0 +1,83 @@
+#ifndef PERSISTENCE_H
+#define PERSISTENCE_H
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "net_mpscQueue.h"
+
+// Dedicated writer thread for the chat logs
+// Appends from all conversations are queued, gathered into one batch per wake-up, written with one
+// write per file and then synced to disk according to the fsync policy (group commit)
+class PersistenceStage
+{
+public:
+    enum class FsyncPolicy {
+        None,           // Never fsync; records count as durable once handed to the OS
+        Interval,       // fsync dirty files at most every syncIntervalMs
+        EveryBatch      // fsync every file touched by a batch before acknowledging it
+    };
+
+    // Called on the persistence thread once the record is durable under the policy (false on write failure)
+    using DurableCallback = std::function<void(bool)>;
+
+    explicit PersistenceStage(FsyncPolicy policy = FsyncPolicy::Interval, uint32_t syncIntervalMs = 100);
+
+    PersistenceStage(const PersistenceStage&) = delete;
+    PersistenceStage& operator=(const PersistenceStage&) = delete;
+
+    // Writes and syncs everything still queued, then stops the thread
+    ~PersistenceStage();
+
+    // Queues bytes to be appended to a file; appends to the same file keep their order
+    void append(const std::string& path, std::string bytes, DurableCallback onDurable = nullptr);
+
+    // Blocks until every append queued before this call has been written to its file
+    void flush();
+
+    FsyncPolicy policy() const { return fsyncPolicy; }
+
+private:
+    struct Record {
+        std::string path;           // Empty for a flush barrier
+        std::string bytes;
+        DurableCallback onDurable;
+        bool stop = false;
+    };
+
+    struct PendingAck {
+        std::string path;
+        DurableCallback onDurable;
+    };
+
+    void run();
+
+    // Appends one file's share of a batch; returns false on failure
+    bool writeFile(const std::string& path, const std::string& bytes);
+
+    // fsyncs every file written since the last sync and acknowledges the waiting records
+    void syncAndAcknowledge();
+
+    // Returns a cached append handle for path
+    std::FILE* openFile(const std::string& path);
+    void closeFiles();
+
+    FsyncPolicy fsyncPolicy;
+    std::chrono::milliseconds syncInterval;
+
+    olc::net::mpscQueue<Record> queue;
+
+    // Persistence thread state
+    std::unordered_map<std::string, std::FILE*> openFiles;
+    std::unordered_map<std::string, bool> dirtyFiles;      // Written since last sync -> write succeeded
+    std::vector<PendingAck> pendingAcks;
+    std::chrono::steady_clock::time_point lastSync;
+
+    std::thread writerThread;
+};
+
+#endif // PERSISTENCE_H
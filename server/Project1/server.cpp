@@ -1,9 +1,13 @@
 #include <iostream>
+#include <algorithm>
 #include <thread>
 #include <chrono>
 #include <ctime>
+#include <cstdlib>
 #include <map>
+#include <unordered_map>
 #include <mutex>
+#include <atomic>
 #include <fstream>
 #include "simdjson.h"
 #include "net_common.h"
@@ -12,17 +16,93 @@
 #include "global_chat.h"
 #include "user_manager.h"
 #include "net_server_chat.h"
+#include "worker_pool.h"
+#include "persistence.h"
+#include "history_stream.h"
+#include "logger.h"
 
 using boost::asio::ip::tcp;
 
+// Name of a message type for statistics reports
+static std::string messageTypeName(CustomMsgTypes type)
+{
+    switch (type) {
+    case CustomMsgTypes::ServerAccept:              return "ServerAccept";
+    case CustomMsgTypes::ServerDeny:                return "ServerDeny";
+    case CustomMsgTypes::ServerPing:                return "ServerPing";
+    case CustomMsgTypes::MessageAll:                return "MessageAll";
+    case CustomMsgTypes::ServerMessage:             return "ServerMessage";
+    case CustomMsgTypes::KeyPress:                  return "KeyPress";
+    case CustomMsgTypes::DirectMessage:             return "DirectMessage";
+    case CustomMsgTypes::RequestClientList:         return "RequestClientList";
+    case CustomMsgTypes::RegisterRequest:           return "RegisterRequest";
+    case CustomMsgTypes::RegisterResponse:          return "RegisterResponse";
+    case CustomMsgTypes::LoginRequest:              return "LoginRequest";
+    case CustomMsgTypes::LoginResponse:             return "LoginResponse";
+    case CustomMsgTypes::ChatRequest:               return "ChatRequest";
+    case CustomMsgTypes::ChatResponse:              return "ChatResponse";
+    case CustomMsgTypes::ClientInfoRequest:         return "ClientInfoRequest";
+    case CustomMsgTypes::ClientInfoResponse:        return "ClientInfoResponse";
+    case CustomMsgTypes::ChatHistoryRequest:        return "ChatHistoryRequest";
+    case CustomMsgTypes::ChatHistoryResponse:       return "ChatHistoryResponse";
+    case CustomMsgTypes::GlobalMessage:             return "GlobalMessage";
+    case CustomMsgTypes::GlobalChatHistoryRequest:  return "GlobalChatHistoryRequest";
+    case CustomMsgTypes::GlobalChatHistoryResponse: return "GlobalChatHistoryResponse";
+    case CustomMsgTypes::HistoryChunk:              return "HistoryChunk";
+    case CustomMsgTypes::HistoryChunkAck:           return "HistoryChunkAck";
+    case CustomMsgTypes::StatsRequest:              return "StatsRequest";
+    case CustomMsgTypes::StatsResponse:             return "StatsResponse";
+    }
+    return "Type " + std::to_string(static_cast<uint32_t>(type));
+}
+
 // Custom server class that inherits from server interface, global chat manager, and server chat interface
 class CustomServer : public olc::net::server_interface<CustomMsgTypes>, public GlobalChatManager, public olc::net::server_chat_interface<CustomMsgTypes>
 {
 public:
-    // Constructor: initializes server with port and user database
-    CustomServer(uint16_t nPort) : olc::net::server_interface<CustomMsgTypes>(nPort), userManager("users.json")
+    // Constructor: initializes server with port, I/O and handler thread counts (0 = hardware cores),
+    // the number of recent global messages kept in memory, the chat logs' fsync policy and user database
+    CustomServer(uint16_t nPort, size_t nIoThreads = 0, size_t nWorkerThreads = 0,
+        size_t nGlobalHistory = GlobalChatManager::DEFAULT_HISTORY_CAPACITY,
+        PersistenceStage::FsyncPolicy fsyncPolicy = PersistenceStage::FsyncPolicy::Interval, uint32_t syncIntervalMs = 100)
+        : olc::net::server_interface<CustomMsgTypes>(nPort, nIoThreads), GlobalChatManager(nGlobalHistory),
+        userManager("users.json"), persistence(fsyncPolicy, syncIntervalMs), workers(nWorkerThreads)
     {
-        std::cout << "[SERVER] User database initialized\n";
+        LOG_INFO("[SERVER] User database initialized");
+
+        // Both chat stores append through the shared persistence thread
+        setPersistence(&persistence);
+        directMessageLog.setPersistence(&persistence);
+
+        // Warm the global history ring so history requests never touch the log
+        loadRecentGlobalMessages();
+
+        // Register message handlers, the shard each one must run on and the largest body it accepts
+        const uint32_t lengthPrefix = sizeof(uint32_t);
+        messageHandlers = {
+            { CustomMsgTypes::RegisterRequest,          { HandlerAffinity::Session,      3 * (lengthPrefix + MAX_CREDENTIAL_SIZE), &CustomServer::handleRegisterRequest } },
+            { CustomMsgTypes::LoginRequest,             { HandlerAffinity::Session,      2 * (lengthPrefix + MAX_CREDENTIAL_SIZE), &CustomServer::handleLoginRequest } },
+            { CustomMsgTypes::GlobalMessage,            { HandlerAffinity::Global,       lengthPrefix + MAX_CHAT_TEXT_SIZE,        &CustomServer::handleGlobalMessage } },
+            { CustomMsgTypes::GlobalChatHistoryRequest, { HandlerAffinity::Sender,       MAX_CONTROL_BODY_SIZE,                    &CustomServer::handleGlobalChatHistoryRequest } },
+            { CustomMsgTypes::RequestClientList,        { HandlerAffinity::Sender,       MAX_CONTROL_BODY_SIZE,                    &CustomServer::handleRequestClientList } },
+            { CustomMsgTypes::DirectMessage,            { HandlerAffinity::Conversation, sizeof(uint32_t) + lengthPrefix + MAX_CHAT_TEXT_SIZE, &CustomServer::handleDirectMessage } },
+            { CustomMsgTypes::ChatRequest,              { HandlerAffinity::Conversation, MAX_CONTROL_BODY_SIZE,                    &CustomServer::handleChatRequest } },
+            { CustomMsgTypes::ChatResponse,             { HandlerAffinity::Conversation, MAX_CONTROL_BODY_SIZE,                    &CustomServer::handleChatResponse } },
+            { CustomMsgTypes::ChatHistoryRequest,       { HandlerAffinity::Conversation, MAX_CONTROL_BODY_SIZE,                    &CustomServer::handleChatHistoryRequest } },
+            { CustomMsgTypes::HistoryChunkAck,          { HandlerAffinity::Sender,       MAX_CONTROL_BODY_SIZE,                    &CustomServer::handleHistoryChunkAck } },
+            { CustomMsgTypes::ServerPing,               { HandlerAffinity::Sender,       MAX_CONTROL_BODY_SIZE,                    &CustomServer::handlePingReply } },
+            { CustomMsgTypes::StatsRequest,             { HandlerAffinity::Sender,       MAX_CONTROL_BODY_SIZE,                    &CustomServer::handleStatsRequest } },
+        };
+
+        // Frames of handled types may carry their handler's largest body; anything else only a few bytes
+        for (const auto& entry : messageHandlers) {
+            setMaxFrameSize(entry.first, sizeof(olc::net::messageHeader<CustomMsgTypes>) + entry.second.maxBodySize);
+        }
+
+        // The statistics report is also written to the log once a minute
+        setMetricsReport(std::chrono::seconds(60), [](uint32_t type) { return messageTypeName(static_cast<CustomMsgTypes>(type)); });
+
+        LOG_INFO("[SERVER] Message handlers running on " << workers.size() << " worker thread(s)");
     }
 
     // Override method called when client is validated - sends welcome message
@@ -35,151 +115,159 @@ public:
     }
 
 private:
+    // Live route to an online user's current connection
+    struct UserRoute {
+        std::shared_ptr<olc::net::connection<CustomMsgTypes>> connection;
+        std::string username;
+    };
+
+    // Which worker shard a handler runs on
+    // Session and Sender messages follow a client's earlier Session and Sender messages still queued or running,
+    // so they complete in the order the client sent them; Session handlers may then run off their shard and are
+    // additionally serialized by sessionMutex. Global and Conversation messages always run on their own shard.
+    enum class HandlerAffinity {
+        Session,        // Login/registration: one shared shard, serializes session table changes
+        Global,         // Global chat: one shared shard, keeps the broadcast order equal to the saved order
+        Sender,         // Any shard, chosen by the sending client
+        Conversation    // Shard chosen by the (sender, peer) user pair, keeps each private conversation ordered
+    };
+
+    using MessageHandlerFn = void (CustomServer::*)(std::shared_ptr<olc::net::connection<CustomMsgTypes>>, olc::net::message<CustomMsgTypes>&);
+
+    struct MessageHandler {
+        HandlerAffinity affinity;
+        uint32_t maxBodySize;       // Larger frames are rejected before their body is buffered
+        MessageHandlerFn handler;
+    };
+
+    // Shard currently used by a client's Session and Sender messages and how many of them are queued or running there
+    struct DispatchRoute {
+        size_t shard = 0;
+        std::shared_ptr<std::atomic<uint32_t>> inFlight;
+    };
+
     UserManager userManager;                                  // Manages user data and authentication
     std::map<uint32_t, std::string> authenticatedUsers;      // Maps client ID to username
     std::map<std::string, uint32_t> userToClientMap;         // Maps username to client ID
+    std::unordered_map<uint32_t, UserRoute> userRoutes;      // Maps user ID to live connection (guarded by authMutex)
     std::mutex authMutex;                                     // Mutex for authentication operations
-    std::mutex chatLogMutex;                                  // Mutex for chat log file operations
-
-    // Formats JSON chat history into readable text format
-    std::string formatChatHistory(const std::string& jsonHistory) {
-        if (jsonHistory.empty()) {
-            return "No messages found in chat history.";
+    std::unordered_map<CustomMsgTypes, MessageHandler> messageHandlers; // Handler registry, read-only after construction
+    std::unordered_map<uint32_t, DispatchRoute> dispatchRoutes; // Maps client ID to its current shard (guarded by dispatchMutex)
+    std::mutex dispatchMutex;                                 // Mutex for dispatch routes
+    std::mutex sessionMutex;                                  // Held by Session handlers for their whole run
+    std::shared_ptr<const std::string> globalHistorySource;  // History body the cached frame was built from
+    olc::net::shared_frame<CustomMsgTypes> globalHistoryFrame; // Encoded GlobalChatHistoryResponse shared by all requesters
+    std::mutex globalHistoryFrameMutex;                      // Mutex for the cached history frame
+    HistoryStreamer historyStreamer;                          // Chunked delivery of large history responses
+    PersistenceStage persistence;                             // Group-commit writer for the chat logs; outlives the workers
+    WorkerPool workers;                                       // Runs message handlers; declared last so it is joined first
+
+    // Points user ID at the given connection, replacing any previous session. Caller must hold authMutex
+    void addUserRoute(uint32_t userID, const std::string& username,
+        std::shared_ptr<olc::net::connection<CustomMsgTypes>> client) {
+        if (userID != 0) {
+            userRoutes[userID] = UserRoute{ std::move(client), username };
         }
+    }
 
-        // Check if history is already formatted to avoid double formatting
-        if (jsonHistory.find("=== Chat History ===") != std::string::npos) {
-            std::cout << "[DEBUG] Already formatted history received, returning as-is\n";
-            return jsonHistory;
+    // Drops the route for a user only if it still points at the given connection. Caller must hold authMutex
+    void removeUserRoute(uint32_t userID, const std::shared_ptr<olc::net::connection<CustomMsgTypes>>& client) {
+        auto it = userRoutes.find(userID);
+        if (it != userRoutes.end() && it->second.connection == client) {
+            userRoutes.erase(it);
         }
+    }
 
-        try {
-            simdjson::dom::parser parser;
-            simdjson::dom::element doc;
-
-            std::cout << "[DEBUG] Raw JSON input: " << jsonHistory.substr(0, 200) << "...\n";
-
-            // Parse the JSON string
-            auto error = parser.parse(jsonHistory).get(doc);
-            if (error != simdjson::SUCCESS) {
-                std::cerr << "[SERVER] JSON parsing failed: " << simdjson::error_message(error) << "\n";
-                return "Error: Invalid JSON format in chat history.";
-            }
+    // Resolves an online user's connection by user ID with a single hash lookup
+    std::shared_ptr<olc::net::connection<CustomMsgTypes>> findUserConnection(uint32_t userID, std::string& username) {
+        std::lock_guard<std::mutex> lock(authMutex);
+        auto it = userRoutes.find(userID);
+        if (it == userRoutes.end()) {
+            return nullptr;
+        }
+        username = it->second.username;
+        return it->second.connection;
+    }
 
-            std::string formattedHistory = "\n=== CHAT HISTORY ===\n";
-
-            // Check if this is a private conversation (has conversation_id field)
-            std::string_view conversationId_view;
-            if (doc["conversation_id"].get(conversationId_view) == simdjson::SUCCESS) {
-                // Private conversation format
-                std::string conversationId(conversationId_view);
-                formattedHistory += "Conversation: " + conversationId + "\n\n";
-
-                simdjson::dom::array messages;
-                if (doc["messages"].get(messages) == simdjson::SUCCESS) {
-                    // Process each message in the conversation
-                    for (auto message : messages) {
-                        std::string_view senderUsername_view;
-                        std::string_view recipientUsername_view;
-                        std::string_view messageText_view;
-                        std::string_view timestamp_view;
-
-                        // Extract message fields
-                        if (message["sender_username"].get(senderUsername_view) == simdjson::SUCCESS &&
-                            message["recipient_username"].get(recipientUsername_view) == simdjson::SUCCESS &&
-                            message["message_text"].get(messageText_view) == simdjson::SUCCESS) {
-
-                            std::string senderUsername(senderUsername_view);
-                            std::string recipientUsername(recipientUsername_view);
-                            std::string messageText(messageText_view);
-                            std::string timestamp = "";
-
-                            // Extract timestamp if available
-                            if (message["timestamp"].get(timestamp_view) == simdjson::SUCCESS) {
-                                timestamp = std::string(timestamp_view);
-                            }
-                            else {
-                                timestamp = "Unknown time";
-                            }
-
-                            // Format message as: [timestamp] sender -> recipient: message
-                            formattedHistory += "[" + timestamp + "] " + senderUsername + " -> " + recipientUsername + ": " + messageText + "\n";
-                        }
-                    }
-                }
-                else {
-                    formattedHistory += "No messages in this conversation.\n";
+    // Picks the worker shard for a message according to its handler's affinity
+    size_t selectShard(const std::shared_ptr<olc::net::connection<CustomMsgTypes>>& client, HandlerAffinity affinity,
+        const olc::net::message<CustomMsgTypes>& msg) {
+        switch (affinity) {
+        case HandlerAffinity::Session:
+            return 0;
+        case HandlerAffinity::Global:
+            return 1;
+        case HandlerAffinity::Conversation: {
+            // Every conversation message starts with the peer's user ID
+            uint32_t senderUserID = 0;
+            {
+                std::lock_guard<std::mutex> lock(authMutex);
+                auto it = authenticatedUsers.find(client->getID());
+                if (it != authenticatedUsers.end()) {
+                    senderUserID = userManager.getUserID(it->second);
                 }
             }
-            else {
-                // Global chat format (no conversation_id)
-                simdjson::dom::array messages;
-                if (doc["messages"].get(messages) == simdjson::SUCCESS) {
-                    // Process each global message
-                    for (auto message : messages) {
-                        std::string_view senderUsername_view;
-                        std::string_view messageText_view;
-                        std::string_view timestamp_view;
-
-                        // Extract message fields for global chat
-                        if (message["sender_username"].get(senderUsername_view) == simdjson::SUCCESS &&
-                            message["message_text"].get(messageText_view) == simdjson::SUCCESS) {
-
-                            std::string senderUsername(senderUsername_view);
-                            std::string messageText(messageText_view);
-                            std::string timestamp = "";
-
-                            // Try to get timestamp from different possible fields
-                            if (message["timestamp"].get(timestamp_view) == simdjson::SUCCESS) {
-                                timestamp = std::string(timestamp_view);
-                            }
-                            else if (message["created_date"].get(timestamp_view) == simdjson::SUCCESS) {
-                                timestamp = std::string(timestamp_view);
-                            }
-                            else {
-                                timestamp = "Unknown time";
-                            }
-
-                            // Format message as: [timestamp] sender: message
-                            formattedHistory += "[" + timestamp + "] " + senderUsername + ": " + messageText + "\n";
-                        }
-                    }
-                }
-                else {
-                    formattedHistory += "No messages found.\n";
-                }
+            if (senderUserID != 0 && msg.body.size() >= sizeof(uint32_t)) {
+                uint32_t peerUserID = 0;
+                std::memcpy(&peerUserID, msg.body.data(), sizeof(uint32_t));
+                uint64_t pair = (uint64_t(std::min(senderUserID, peerUserID)) << 32) | std::max(senderUserID, peerUserID);
+                return std::hash<uint64_t>()(pair);
             }
+            // Unauthenticated senders are answered with an error; any shard will do
+            return client->getID();
+        }
+        case HandlerAffinity::Sender:
+        default:
+            return client->getID();
+        }
+    }
 
-            formattedHistory += "=== END OF HISTORY ===\n";
-            return formattedHistory;
+    // Builds a ChatHistoryResponse for one page of history; partnerID is the other user in the conversation
+    olc::net::message<CustomMsgTypes> makeChatHistoryResponse(uint32_t partnerID, const HistoryPage& page)
+    {
+        olc::net::message<CustomMsgTypes> historyResponse;
+        historyResponse.header.id = CustomMsgTypes::ChatHistoryResponse;
+
+        historyResponse << partnerID;
+
+        // Cursor for the next older page: the page's first sequence number, 0 at the start of the conversation
+        historyResponse << page.firstSeq;
+        historyResponse << page.total;
+        historyResponse << page.count;
 
+        // Entries are already encoded, copy them in one block
+        historyResponse.writeBytes(page.entries.data(), page.entries.size());
+        return historyResponse;
+    }
+
+    // Sends one page of history as a ChatHistoryResponse, or as a chunk stream if it is large
+    void sendChatHistory(std::shared_ptr<olc::net::connection<CustomMsgTypes>> client, uint32_t partnerID, const HistoryPage& page)
+    {
+        if (page.entries.size() <= HISTORY_CHUNK_SIZE) {
+            client->send(makeChatHistoryResponse(partnerID, page));
+            return;
         }
-        catch (const std::exception& e) {
-            std::cerr << "[SERVER] Exception in formatChatHistory: " << e.what() << "\n";
-            std::cerr << "[SERVER] JSON content (first 500 chars): " << jsonHistory.substr(0, 500) << "\n";
-            return "Error: Unable to format chat history - " + std::string(e.what());
+
+        // Every chunk repeats the response fields in front of the entry count
+        olc::net::message<CustomMsgTypes> header;
+        header << partnerID;
+        header << page.firstSeq;
+        header << page.total;
+
+        if (!historyStreamer.send(client, CustomMsgTypes::ChatHistoryResponse,
+            std::string(header.body.begin(), header.body.end()), page.entries)) {
+            LOG_WARN("[SERVER] History stream budget exhausted, chat history for client ID=" << client->getID() << " refused");
+            SendMessageToClient(client, "Error: The server is busy sending chat history, please try again later");
         }
     }
 
-// Saves a chat message to the appropriate JSON file for the conversation
+// Appends a chat message to the conversation's record log
 void saveChatMessage(const std::string& senderUsername, uint32_t senderUserID,
     const std::string& recipientUsername, uint32_t recipientUserID,
-    const std::string& messageText) {
+    const std::string& messageText, PersistenceStage::DurableCallback onDurable = nullptr) {
     std::lock_guard<std::mutex> lock(chatLogMutex);
 
     try {
-        // Generate filename for the conversation between these two users
-        std::string chatFileName = generateChatFileName(senderUsername, recipientUsername);
-
-        // Create conversation ID (alphabetical order for consistency)
-        std::string conversationID;
-        if (senderUsername < recipientUsername) {
-            conversationID = senderUsername + "_" + recipientUsername;
-        }
-        else {
-            conversationID = recipientUsername + "_" + senderUsername;
-        }
-
         // Get current timestamp
         auto now = std::chrono::system_clock::now();
         time_t time_now = std::chrono::system_clock::to_time_t(now);
@@ -194,139 +282,36 @@ void saveChatMessage(const std::string& senderUsername, uint32_t senderUserID,
 #endif
         std::strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &timeinfo);
 
-        // Generate unique message ID based on timestamp in milliseconds
-        auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count();
-
-        // Escape special characters in message text for JSON format
-        std::string escapedMessageText = messageText;
-        size_t pos = 0;
-        // Escape double quotes
-        while ((pos = escapedMessageText.find("\"", pos)) != std::string::npos) {
-            escapedMessageText.replace(pos, 1, "\\\"");
-            pos += 2;
-        }
-        // Escape newlines
-        while ((pos = escapedMessageText.find("\n", pos)) != std::string::npos) {
-            escapedMessageText.replace(pos, 1, "\\n");
-            pos += 2;
-        }
-        // Escape carriage returns
-        while ((pos = escapedMessageText.find("\r", pos)) != std::string::npos) {
-            escapedMessageText.replace(pos, 1, "\\r");
-            pos += 2;
-        }
-
-        // Read existing file content if it exists
-        std::string existingContent;
-        std::ifstream inFile(chatFileName);
-        bool fileExists = false;
-
-        if (inFile.is_open()) {
-            std::string line;
-            while (std::getline(inFile, line)) {
-                existingContent += line + "\n";
-            }
-            inFile.close();
-            fileExists = !existingContent.empty();
-        }
-
-        // Create new message JSON object
-        std::string newMessage = "    {\n";
-        newMessage += "      \"message_id\": " + std::to_string(timestamp) + ",\n";
-        newMessage += "      \"conversation_id\": \"" + conversationID + "\",\n";
-        newMessage += "      \"sender_username\": \"" + senderUsername + "\",\n";
-        newMessage += "      \"sender_user_id\": " + std::to_string(senderUserID) + ",\n";
-        newMessage += "      \"recipient_username\": \"" + recipientUsername + "\",\n";
-        newMessage += "      \"recipient_user_id\": " + std::to_string(recipientUserID) + ",\n";
-        newMessage += "      \"message_text\": \"" + escapedMessageText + "\",\n";
-        newMessage += "      \"timestamp\": \"" + std::string(timeStr) + "\",\n";
-        newMessage += "      \"message_type\": \"direct_message\"\n";
-        newMessage += "    }";
-
-        // Open file for writing
-        std::ofstream outFile(chatFileName);
-        if (outFile.is_open()) {
-            if (!fileExists) {
-                // Create new conversation file with initial structure
-                outFile << "{\n";
-                outFile << "  \"conversation_id\": \"" + conversationID + "\",\n";
-                outFile << "  \"participants\": [\"" + senderUsername + "\", \"" + recipientUsername + "\"],\n";
-                outFile << "  \"created_date\": \"" + std::string(timeStr) + "\",\n";
-                outFile << "  \"messages\": [\n";
-                outFile << newMessage << "\n";
-                outFile << "  ]\n";
-                outFile << "}\n";
-
-                std::cout << "[SERVER] Created new chat file: " << chatFileName << "\n";
-            }
-            else {
-                // Parse existing JSON and append new message
-                try {
-                    simdjson::dom::parser parser;
-                    simdjson::dom::element doc;
-                    auto error = parser.parse(existingContent).get(doc);
-
-                    if (error == simdjson::SUCCESS) {
-                        // Valid JSON, append new message to messages array
-                        size_t messagesEndPos = existingContent.rfind("  ]");
-                        if (messagesEndPos != std::string::npos) {
-                            // Check if messages array exists
-                            size_t messagesStartPos = existingContent.find("\"messages\": [");
-                            if (messagesStartPos != std::string::npos) {
-                                std::string messagesSection = existingContent.substr(
-                                    messagesStartPos + 13, messagesEndPos - messagesStartPos - 13);
-
-                                // Check if there are existing messages in the array
-                                bool hasExistingMessages = messagesSection.find("{") != std::string::npos;
-
-                                if (hasExistingMessages) {
-                                    // Add comma separator before new message
-                                    existingContent.insert(messagesEndPos, ",\n" + newMessage + "\n");
-                                }
-                                else {
-                                    // First message in array
-                                    existingContent.insert(messagesEndPos, newMessage + "\n");
-                                }
-                            }
-                        }
-                        outFile << existingContent;
-                    }
-                    else {
-                        throw std::runtime_error("Invalid JSON structure");
-                    }
-                }
-                catch (const std::exception& e) {
-                    // If JSON is corrupted, recreate the file
-                    std::cerr << "[SERVER] JSON corrupted, recreating file: " << e.what() << "\n";
-                    outFile << "{\n";
-                    outFile << "  \"conversation_id\": \"" + conversationID + "\",\n";
-                    outFile << "  \"participants\": [\"" + senderUsername + "\", \"" + recipientUsername + "\"],\n";
-                    outFile << "  \"created_date\": \"" + std::string(timeStr) + "\",\n";
-                    outFile << "  \"messages\": [\n";
-                    outFile << newMessage << "\n";
-                    outFile << "  ]\n";
-                    outFile << "}\n";
-                }
-            }
-
-            outFile.close();
-            std::cout << "[SERVER] Chat message saved to " << chatFileName
-                << " with ID=" << timestamp << "\n";
+        ChatRecord record;
+        // Unique message ID based on timestamp in milliseconds
+        record.messageID = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+        record.senderUserID = senderUserID;
+        record.recipientUserID = recipientUserID;
+        record.senderUsername = senderUsername;
+        record.recipientUsername = recipientUsername;
+        record.timestamp = timeStr;
+        record.messageText = messageText;
+
+        // One append per message, the rest of the conversation is never rewritten
+        if (directMessageLog.append(senderUsername, recipientUsername, record, std::move(onDurable))) {
+            // Keep a cached history of this conversation current instead of invalidating it
+            historyCache.append(DirectMessageLog::fileName(senderUsername, recipientUsername), encodeChatEntry(record));
+
+            LOG_DEBUG("[SERVER] Chat message queued for " << DirectMessageLog::fileName(senderUsername, recipientUsername)
+                << " with ID=" << record.messageID);
         }
         else {
-            std::cerr << "[SERVER] Failed to open chat file for writing: " << chatFileName << "\n";
+            LOG_ERROR("[SERVER] Failed to save chat message between " << senderUsername << " and " << recipientUsername);
         }
-
     }
     catch (const std::exception& e) {
-        std::cerr << "[SERVER] Error saving chat message: " << e.what() << "\n";
+        LOG_ERROR("[SERVER] Error saving chat message: " << e.what());
     }
 }
 protected:
     virtual bool onClientConnect(std::shared_ptr<olc::net::connection<CustomMsgTypes>> client) override
     {
-        std::cout << "[SERVER] New client connecting with temporary ID=" << client->getID() << "\n";
+        LOG_INFO("[SERVER] New client connecting with temporary ID=" << client->getID());
 
         // When connecting, we now DO NOT send ID to the client
         // They will receive their permanent ID only after registration/authorization
@@ -335,7 +320,7 @@ protected:
 
         // Temporary ID will be used by the server only
         client->send(msg);
-        std::cout << "[SERVER] Sent ServerAccept to temporary client\n";
+        LOG_INFO("[SERVER] Sent ServerAccept to temporary client");
 
         // Sending invitation to register or log in
         SendMessageToClient(client, "Please register or log in to get access to server features");
@@ -346,7 +331,16 @@ protected:
     virtual void onClientDisconnect(std::shared_ptr<olc::net::connection<CustomMsgTypes>> client) override
     {
         uint32_t clientID = client->getID();
-        std::cout << "[SERVER] Client disconnecting: ID=" << clientID << "\n";
+        LOG_INFO("[SERVER] Client disconnecting: ID=" << clientID);
+
+        // Forget the client's dispatch route; handlers still running keep their own reference
+        {
+            std::lock_guard<std::mutex> lock(dispatchMutex);
+            dispatchRoutes.erase(clientID);
+        }
+
+        // Unsent history chunks are no longer needed
+        historyStreamer.drop(clientID);
 
         // Check if the client is in the list of authenticated users
         std::string username;
@@ -364,11 +358,12 @@ protected:
                 // Update user online status to offline
                 userManager.setUserOnlineStatus(username, false);
 
-                // Remove the connection from both mappings
+                // Remove the connection from all mappings
+                removeUserRoute(userManager.getUserID(username), client);
                 userToClientMap.erase(username);
                 authenticatedUsers.erase(clientID);
 
-                std::cout << "[SERVER] User " << username << " (Client #" << clientID << ") disconnected\n";
+                LOG_INFO("[SERVER] User " << username << " (Client #" << clientID << ") disconnected");
             }
         } // Mutex is released here
 
@@ -378,947 +373,972 @@ protected:
             BroadcastMessage(disconnectMsg);
         }
         else {
-            std::cout << "[SERVER] Unauthenticated client disconnected: ID=" << clientID << "\n";
+            LOG_INFO("[SERVER] Unauthenticated client disconnected: ID=" << clientID);
         }
     }
 
 
+    // Queues the message on the worker shard chosen by its handler's affinity
     virtual void onMessage(std::shared_ptr<olc::net::connection<CustomMsgTypes>> client, olc::net::message<CustomMsgTypes>& msg) override
     {
-        std::cout << "[SERVER] Message received from client ID=" << client->getID()
+        LOG_DEBUG("[SERVER] Message received from client ID=" << client->getID()
             << ", MsgID=" << static_cast<uint32_t>(msg.header.id)
-            << ", Size=" << msg.header.size << "\n";
-
-        // Reset read position before processing message to ensure proper data extraction
-        msg.reset_read_position();
-
-        switch (msg.header.id)
-        {
+            << ", Size=" << msg.header.size);
 
+        auto it = messageHandlers.find(msg.header.id);
+        if (it == messageHandlers.end()) {
+            LOG_WARN("[SERVER] Unknown message type: " << static_cast<uint32_t>(msg.header.id));
+            return;
+        }
 
+        HandlerAffinity affinity = it->second.affinity;
+        MessageHandlerFn handler = it->second.handler;
+        size_t shard = selectShard(client, affinity, msg);
 
-        case CustomMsgTypes::GlobalMessage:
+        // Keep a client's Session and Sender messages on the shard still running its earlier ones so they complete
+        // in order. Global and Conversation messages never move: their shard is what orders them against other
+        // clients' messages to the same conversation or the global chat
+        bool pinned = affinity == HandlerAffinity::Session || affinity == HandlerAffinity::Sender;
+        std::shared_ptr<std::atomic<uint32_t>> inFlight;
         {
-            std::cout << "[SERVER] Processing GlobalMessage from client ID=" << client->getID() << "\n";
+            std::lock_guard<std::mutex> lock(dispatchMutex);
+            auto route = dispatchRoutes.find(client->getID());
+            if (route == dispatchRoutes.end()) {
+                // Messages queued before the client was removed are dropped instead of recreating its route
+                if (getClientByID(client->getID()) != client) {
+                    LOG_DEBUG("[SERVER] Dropping message from removed client ID=" << client->getID());
+                    return;
+                }
+                route = dispatchRoutes.emplace(client->getID(),
+                    DispatchRoute{ shard, std::make_shared<std::atomic<uint32_t>>(0) }).first;
+            }
+            if (pinned) {
+                if (route->second.inFlight->load(std::memory_order_acquire) == 0) {
+                    route->second.shard = shard;
+                }
+                else {
+                    shard = route->second.shard;
+                }
+                route->second.inFlight->fetch_add(1, std::memory_order_relaxed);
+                inFlight = route->second.inFlight;
+            }
+        }
+
+        // Session handlers may be kept off their own shard, their lock still serializes them
+        std::mutex* serializer = affinity == HandlerAffinity::Session ? &sessionMutex : nullptr;
 
-            // Check if the sender is authenticated
-            std::string senderUsername;
-            bool senderAuthenticated = false;
+        workers.submit(shard, [this, client, handler, inFlight, serializer, message = std::move(msg)]() mutable {
+            // Reset read position before processing message to ensure proper data extraction
+            message.reset_read_position();
+            std::unique_lock<std::mutex> serialized;
+            if (serializer) {
+                serialized = std::unique_lock<std::mutex>(*serializer);
+            }
 
+            auto started = std::chrono::steady_clock::now();
             {
-                std::lock_guard<std::mutex> lock(authMutex);
-                auto it = authenticatedUsers.find(client->getID());
-                if (it != authenticatedUsers.end()) {
-                    senderUsername = it->second;
-                    senderAuthenticated = true;
+                // Replies sent by a traced message's handler are timed until they have been written
+                olc::net::handler_trace_scope traceScope(message.trace);
+                try {
+                    (this->*handler)(client, message);
+                }
+                catch (const std::exception& e) {
+                    LOG_ERROR("[SERVER] Error handling message from client ID=" << client->getID() << ": " << e.what());
                 }
             }
-
-            if (!senderAuthenticated) {
-                SendMessageToClient(client, "Error: You must be logged in to send global messages");
-                break;
+            Metrics::instance().handlerTime(static_cast<uint32_t>(message.header.id), std::chrono::steady_clock::now() - started);
+            if (inFlight) {
+                inFlight->fetch_sub(1, std::memory_order_release);
             }
+        });
+    }
 
-            // Get the sender's user ID
-            uint32_t senderUserID = userManager.getUserID(senderUsername);
-
-            // Extract message size from the packet
-            uint32_t messageSize = 0;
-            msg >> messageSize;
+private:
+    // Saves a global chat message and broadcasts it to every other authenticated user
+    void handleGlobalMessage(std::shared_ptr<olc::net::connection<CustomMsgTypes>> client, olc::net::message<CustomMsgTypes>& msg)
+    {
+        LOG_DEBUG("[SERVER] Processing GlobalMessage from client ID=" << client->getID());
 
-            if (messageSize > 10000) { // Size limit check
-                std::cerr << "[SERVER] Global message size too large: " << messageSize << std::endl;
-                break;
-            }
+        // Check if the sender is authenticated
+        std::string senderUsername;
+        bool senderAuthenticated = false;
 
-            // Read the message text character by character
-            std::string messageText;
-            messageText.reserve(messageSize);
-            for (uint32_t i = 0; i < messageSize; i++) {
-                char c;
-                msg >> c;
-                messageText.push_back(c);
+        {
+            std::lock_guard<std::mutex> lock(authMutex);
+            auto it = authenticatedUsers.find(client->getID());
+            if (it != authenticatedUsers.end()) {
+                senderUsername = it->second;
+                senderAuthenticated = true;
             }
+        }
 
-            std::cout << "[SERVER] User " << senderUsername
-                << " sent global message: " << messageText << "\n";
+        if (!senderAuthenticated) {
+            SendMessageToClient(client, "Error: You must be logged in to send global messages");
+            return;
+        }
 
-            // Save the message to persistent storage
-            saveGlobalMessage(senderUsername, senderUserID, messageText);
+        // Get the sender's user ID
+        uint32_t senderUserID = userManager.getUserID(senderUsername);
 
-            // Broadcast the message to all authenticated users
-            olc::net::message<CustomMsgTypes> globalMsg;
-            globalMsg.header.id = CustomMsgTypes::GlobalMessage;
+        // Extract the length-prefixed message text in one read
+        std::string messageText;
+        if (!msg.readString(messageText, MAX_CHAT_TEXT_SIZE)) { // Size limit check
+            LOG_WARN("[SERVER] Invalid or too large global message");
+            return;
+        }
 
-            // Pack sender's user ID
-            globalMsg << senderUserID;
+        LOG_DEBUG("[SERVER] User " << senderUsername
+            << " sent global message: " << messageText);
 
-            // Pack message size and content
-            uint32_t fullSize = static_cast<uint32_t>(messageText.size());
-            globalMsg << fullSize;
-            for (const char& c : messageText) {
-                globalMsg << c;
+        // Save the message to persistent storage
+        // The sender is only told if the write fails; the broadcast does not wait for the disk
+        saveGlobalMessage(senderUsername, senderUserID, messageText, [this, client](bool durable) {
+            if (!durable) {
+                SendMessageToClient(client, "Warning: your global message could not be saved to chat history");
             }
+        });
 
-            // Send to all authenticated clients except the sender
-            {
-                std::lock_guard<std::mutex> lock(authMutex);
-                for (const auto& pair : authenticatedUsers) {
-                    uint32_t clientID = pair.first;
-                    if (clientID != client->getID()) { // Don't send to sender
-                        auto recipient = getClientByID(clientID);
-                        if (recipient && recipient->isConnected()) {
-                            recipient->send(globalMsg);
-                        }
-                    }
-                }
-            }
+        // Broadcast the message to all authenticated users
+        olc::net::message<CustomMsgTypes> globalMsg;
+        globalMsg.header.id = CustomMsgTypes::GlobalMessage;
 
-            // Send confirmation to the sender
-            SendMessageToClient(client, "Your global message has been sent to all users");
-            std::cout << "[SERVER] Global message broadcasted to all users\n";
-        }
-        break;
+        // Pack sender's user ID
+        globalMsg << senderUserID;
 
-        case CustomMsgTypes::GlobalChatHistoryRequest:
-        {
-            std::cout << "[SERVER] Processing GlobalChatHistoryRequest from client ID=" << client->getID() << "\n";
+        // Pack message size and content
+        globalMsg << messageText;
 
-            // Verify that the requester is authenticated
-            std::string requesterUsername;
-            bool requesterAuthenticated = false;
+        // Serialize once; every recipient shares the same immutable frame
+        // Chat is reliable: a recipient too slow to keep up is handled by the slow-consumer policy, never by
+        // silently losing messages (ephemeral delivery is only meant for presence-style updates)
+        auto globalFrame = olc::net::make_shared_frame(globalMsg);
 
-            {
-                std::lock_guard<std::mutex> lock(authMutex);
-                auto it = authenticatedUsers.find(client->getID());
-                if (it != authenticatedUsers.end()) {
-                    requesterUsername = it->second;
-                    requesterAuthenticated = true;
+        // Send to all authenticated clients except the sender
+        {
+            std::lock_guard<std::mutex> lock(authMutex);
+            for (const auto& pair : authenticatedUsers) {
+                uint32_t clientID = pair.first;
+                if (clientID != client->getID()) { // Don't send to sender
+                    auto recipient = getClientByID(clientID);
+                    if (recipient && recipient->isConnected()) {
+                        recipient->send(globalFrame);
+                    }
                 }
             }
+        }
 
-            if (!requesterAuthenticated) {
-                SendMessageToClient(client, "Error: You must be logged in to request global chat history");
-                break;
-            }
-
-            std::cout << "[SERVER] User " << requesterUsername << " requested global chat history\n";
-
-            // Load and format the global chat history
-            std::string rawGlobalChatHistory = loadGlobalChatHistory();
-            std::string formattedHistory = formatChatHistory(rawGlobalChatHistory);
+        // Send confirmation to the sender
+        SendMessageToClient(client, "Your global message has been sent to all users");
+        LOG_DEBUG("[SERVER] Global message broadcasted to all users");
+    }
 
-            // Prepare the response message
-            olc::net::message<CustomMsgTypes> historyResponse;
-            historyResponse.header.id = CustomMsgTypes::GlobalChatHistoryResponse;
+    // Sends the formatted global chat history to the requester
+    void handleGlobalChatHistoryRequest(std::shared_ptr<olc::net::connection<CustomMsgTypes>> client, [[maybe_unused]] olc::net::message<CustomMsgTypes>& msg)
+    {
+        LOG_DEBUG("[SERVER] Processing GlobalChatHistoryRequest from client ID=" << client->getID());
 
-            // Pack the formatted history size and content as string
-            uint32_t historySize = static_cast<uint32_t>(formattedHistory.size());
-            historyResponse << historySize;
+        // Verify that the requester is authenticated
+        std::string requesterUsername;
+        bool requesterAuthenticated = false;
 
-            for (const char& c : formattedHistory) {
-                historyResponse << c;
+        {
+            std::lock_guard<std::mutex> lock(authMutex);
+            auto it = authenticatedUsers.find(client->getID());
+            if (it != authenticatedUsers.end()) {
+                requesterUsername = it->second;
+                requesterAuthenticated = true;
             }
+        }
 
-            // Send the history to the requesting client
-            client->send(historyResponse);
-
-            std::cout << "[SERVER] Formatted global chat history sent to " << requesterUsername
-                << " (size: " << historySize << " bytes)\n";
+        if (!requesterAuthenticated) {
+            SendMessageToClient(client, "Error: You must be logged in to request global chat history");
+            return;
         }
-        break;
-        case CustomMsgTypes::ChatRequest:
-        {
-            std::cout << "[SERVER] Processing ChatRequest from client ID=" << client->getID() << "\n";
 
-            // Verify that the sender is authenticated
-            std::string senderUsername;
-            bool senderAuthenticated = false;
+        LOG_DEBUG("[SERVER] User " << requesterUsername << " requested global chat history");
 
-            {
-                std::lock_guard<std::mutex> lock(authMutex);
-                auto it = authenticatedUsers.find(client->getID());
-                if (it != authenticatedUsers.end()) {
-                    senderUsername = it->second;
-                    senderAuthenticated = true;
-                }
-            }
+        // The history comes from the in-memory ring, already encoded
+        std::shared_ptr<const std::string> encodedHistory = recentGlobalHistory();
 
-            if (!senderAuthenticated) {
-                SendMessageToClient(client, "Error: You must be logged in to send chat requests");
-                break;
+        // Large histories are streamed in chunks; the body starts with the uint32 entry count
+        std::string_view entries = std::string_view(*encodedHistory).substr(sizeof(uint32_t));
+        if (entries.size() > HISTORY_CHUNK_SIZE) {
+            if (!historyStreamer.send(client, CustomMsgTypes::GlobalChatHistoryResponse, std::string(), entries)) {
+                LOG_WARN("[SERVER] History stream budget exhausted, global history for " << requesterUsername << " refused");
+                SendMessageToClient(client, "Error: The server is busy sending chat history, please try again later");
+                return;
             }
+            LOG_DEBUG("[SERVER] Global chat history streamed to " << requesterUsername
+                << " (size: " << encodedHistory->size() << " bytes)");
+            return;
+        }
 
-            // Extract the recipient's user ID from the message
-            uint32_t recipientUserID = 0;
-            msg >> recipientUserID;
+        // Encode the response once and reuse it until a new message changes the history
+        olc::net::shared_frame<CustomMsgTypes> historyFrame;
+        {
+            std::lock_guard<std::mutex> lock(globalHistoryFrameMutex);
+            if (globalHistorySource != encodedHistory) {
+                olc::net::message<CustomMsgTypes> historyResponse;
+                historyResponse.header.id = CustomMsgTypes::GlobalChatHistoryResponse;
+                historyResponse.writeBytes(encodedHistory->data(), encodedHistory->size());
+
+                globalHistoryFrame = olc::net::make_shared_frame(historyResponse);
+                globalHistorySource = encodedHistory;
+            }
+            historyFrame = globalHistoryFrame;
+        }
 
-            std::cout << "[SERVER] User " << senderUsername
-                << " sent chat request to UserID #" << recipientUserID << "\n";
+        // Send the history to the requesting client
+        client->send(historyFrame);
 
-            // Find the recipient connection by user ID
-            std::shared_ptr<olc::net::connection<CustomMsgTypes>> recipient = nullptr;
-            std::string recipientUsername;
+        LOG_DEBUG("[SERVER] Global chat history sent to " << requesterUsername
+            << " (size: " << encodedHistory->size() << " bytes)");
+    }
 
-            {
-                std::lock_guard<std::mutex> lock(authMutex);
+    // Releases the next chunk of a history stream once the client has processed one
+    void handleHistoryChunkAck(std::shared_ptr<olc::net::connection<CustomMsgTypes>> client, olc::net::message<CustomMsgTypes>& msg)
+    {
+        uint32_t streamID = 0;
+        msg >> streamID;
+        historyStreamer.acknowledge(client, streamID);
+    }
 
-                // Search through authenticated users to find the one with matching user ID
-                for (auto it = authenticatedUsers.begin(); it != authenticatedUsers.end(); ++it) {
-                    uint32_t clientID = it->first;
-                    std::string username = it->second;
+    // A client echoing a heartbeat ping; the connection already recorded the activity
+    void handlePingReply([[maybe_unused]] std::shared_ptr<olc::net::connection<CustomMsgTypes>> client, [[maybe_unused]] olc::net::message<CustomMsgTypes>& msg)
+    {
+    }
 
-                    uint32_t userID = userManager.getUserID(username);
-                    if (userID == recipientUserID) {
-                        recipient = getClientByID(clientID);
-                        recipientUsername = username;
-                        break;
-                    }
-                }
+    // Sends the statistics report to a user with admin rights
+    void handleStatsRequest(std::shared_ptr<olc::net::connection<CustomMsgTypes>> client, [[maybe_unused]] olc::net::message<CustomMsgTypes>& msg)
+    {
+        std::string username;
+        {
+            std::lock_guard<std::mutex> lock(authMutex);
+            auto it = authenticatedUsers.find(client->getID());
+            if (it != authenticatedUsers.end()) {
+                username = it->second;
             }
+        }
 
-            if (recipient != nullptr && recipient->isConnected()) {
-                // Forward the chat request to the recipient
-                olc::net::message<CustomMsgTypes> chatRequestMsg;
-                chatRequestMsg.header.id = CustomMsgTypes::ChatRequest;
+        // Admin rights are a flag in the user store, a username alone grants nothing
+        if (username.empty() || !userManager.isAdmin(username)) {
+            LOG_WARN("[SERVER] Client #" << client->getID() << " requested statistics without admin rights");
+            SendMessageToClient(client, "Error: Server statistics are only available to administrators");
+            return;
+        }
 
-                // Pack the sender's user ID
-                uint32_t senderUserID = userManager.getUserID(senderUsername);
-                chatRequestMsg << senderUserID;
+        olc::net::message<CustomMsgTypes> response;
+        response.header.id = CustomMsgTypes::StatsResponse;
+        response << statsReport();
+        client->send(response);
+    }
 
-                // Send the request to the recipient
-                recipient->send(chatRequestMsg);
-                std::cout << "[SERVER] Chat request forwarded to user " << recipientUsername
-                    << " (UserID #" << recipientUserID << ")\n";
+    // Forwards a chat request to the target user
+    void handleChatRequest(std::shared_ptr<olc::net::connection<CustomMsgTypes>> client, olc::net::message<CustomMsgTypes>& msg)
+    {
+        LOG_DEBUG("[SERVER] Processing ChatRequest from client ID=" << client->getID());
 
-                // Send confirmation to the sender
-                SendMessageToClient(client, "Chat request sent to " + recipientUsername);
-            }
-            else {
-                // Recipient not found or offline
-                SendMessageToClient(client, "Error: User with ID #" + std::to_string(recipientUserID) + " not found or offline");
-                std::cout << "[SERVER] Failed to forward chat request: UserID #" << recipientUserID << " not found or offline\n";
+        // Verify that the sender is authenticated
+        std::string senderUsername;
+        bool senderAuthenticated = false;
+
+        {
+            std::lock_guard<std::mutex> lock(authMutex);
+            auto it = authenticatedUsers.find(client->getID());
+            if (it != authenticatedUsers.end()) {
+                senderUsername = it->second;
+                senderAuthenticated = true;
             }
         }
-        break;
-        case CustomMsgTypes::ChatResponse:
-        {
-            std::cout << "[SERVER] Processing ChatResponse from client ID=" << client->getID() << "\n";
 
-            // Check if the sender is authenticated
-            std::string senderUsername;
-            bool senderAuthenticated = false;
+        if (!senderAuthenticated) {
+            SendMessageToClient(client, "Error: You must be logged in to send chat requests");
+            return;
+        }
 
-            {
-                std::lock_guard<std::mutex> lock(authMutex);
-                auto it = authenticatedUsers.find(client->getID());
-                if (it != authenticatedUsers.end()) {
-                    senderUsername = it->second;
-                    senderAuthenticated = true;
-                }
-            }
+        // Extract the recipient's user ID from the message
+        uint32_t recipientUserID = 0;
+        msg >> recipientUserID;
 
-            if (!senderAuthenticated) {
-                SendMessageToClient(client, "Error: You must be logged in to respond to chat requests");
-                break;
-            }
+        LOG_INFO("[SERVER] User " << senderUsername
+            << " sent chat request to UserID #" << recipientUserID);
 
-            // Extract the recipient user ID (the one who sent the request)
-            uint32_t recipientUserID = 0;
-            msg >> recipientUserID;
+        // Find the recipient connection by user ID
+        std::string recipientUsername;
+        auto recipient = findUserConnection(recipientUserID, recipientUsername);
 
-            // Extract the response (accept/decline)
-            bool accepted = false;
-            msg >> accepted;
+        if (recipient != nullptr && recipient->isConnected()) {
+            // Forward the chat request to the recipient
+            olc::net::message<CustomMsgTypes> chatRequestMsg;
+            chatRequestMsg.header.id = CustomMsgTypes::ChatRequest;
 
-            std::cout << "[SERVER] User " << senderUsername
-                << " responded to chat request from UserID #" << recipientUserID
-                << " with answer: " << (accepted ? "ACCEPTED" : "DECLINED") << "\n";
+            // Pack the sender's user ID
+            uint32_t senderUserID = userManager.getUserID(senderUsername);
+            chatRequestMsg << senderUserID;
 
-            // Find the recipient client (the one who sent the request)
-            std::shared_ptr<olc::net::connection<CustomMsgTypes>> recipient = nullptr;
-            std::string recipientUsername;
+            // Send the request to the recipient
+            recipient->send(chatRequestMsg);
+            LOG_DEBUG("[SERVER] Chat request forwarded to user " << recipientUsername
+                << " (UserID #" << recipientUserID << ")");
 
-            { 
-                std::lock_guard<std::mutex> lock(authMutex);
+            // Send confirmation to the sender
+            SendMessageToClient(client, "Chat request sent to " + recipientUsername);
+        }
+        else {
+            // Recipient not found or offline
+            SendMessageToClient(client, "Error: User with ID #" + std::to_string(recipientUserID) + " not found or offline");
+            LOG_INFO("[SERVER] Failed to forward chat request: UserID #" << recipientUserID << " not found or offline");
+        }
+    }
 
-                // Find the authenticated user whose userID matches recipientUserID
-                for (auto it = authenticatedUsers.begin(); it != authenticatedUsers.end(); ++it) {
-                    uint32_t clientID = it->first;
-                    std::string username = it->second;
+    // Forwards the answer to a chat request and, if accepted, sends the conversation history to both users
+    void handleChatResponse(std::shared_ptr<olc::net::connection<CustomMsgTypes>> client, olc::net::message<CustomMsgTypes>& msg)
+    {
+        LOG_DEBUG("[SERVER] Processing ChatResponse from client ID=" << client->getID());
 
-                    uint32_t userID = userManager.getUserID(username);
-                    if (userID == recipientUserID) {
-                        recipient = getClientByID(clientID);
-                        recipientUsername = username;
-                        break;
-                    }
-                }
+        // Check if the sender is authenticated
+        std::string senderUsername;
+        bool senderAuthenticated = false;
+
+        {
+            std::lock_guard<std::mutex> lock(authMutex);
+            auto it = authenticatedUsers.find(client->getID());
+            if (it != authenticatedUsers.end()) {
+                senderUsername = it->second;
+                senderAuthenticated = true;
             }
+        }
 
-            if (recipient != nullptr && recipient->isConnected()) {
-                // Create response message for the original requester
-                olc::net::message<CustomMsgTypes> chatResponseMsg;
-                chatResponseMsg.header.id = CustomMsgTypes::ChatResponse;
-
-                // Add the sender's user ID (the one who accepted/declined)
-                uint32_t senderUserID = userManager.getUserID(senderUsername);
-                chatResponseMsg << senderUserID;
-
-                // Add the response status
-                chatResponseMsg << accepted;
-
-                // Send the response to the recipient
-                recipient->send(chatResponseMsg);
-                std::cout << "[SERVER] Chat response forwarded to user " << recipientUsername
-                    << " (UserID #" << recipientUserID << ")\n";
-
-                // If accepted, automatically send chat history to both users
-                if (accepted) {
-                    // Load raw chat history from file
-                    std::string rawChatHistory = loadChatHistory(senderUsername, recipientUsername);
-
-                    if (!rawChatHistory.empty()) {
-                        // Format history for display
-                        std::string formattedHistory = formatChatHistory(rawChatHistory);
-
-                        // Send history to the first user (responder)
-                        olc::net::message<CustomMsgTypes> historyMsg1;
-                        historyMsg1.header.id = CustomMsgTypes::ChatHistoryResponse;
-                        historyMsg1 << recipientUserID; // ID of the chat partner
-
-                        uint32_t historySize1 = static_cast<uint32_t>(formattedHistory.size());
-                        historyMsg1 << historySize1;
-                        for (const char& c : formattedHistory) {
-                            historyMsg1 << c;
-                        }
-                        client->send(historyMsg1);
+        if (!senderAuthenticated) {
+            SendMessageToClient(client, "Error: You must be logged in to respond to chat requests");
+            return;
+        }
 
-                        // Send the same history to the second user (original requester)
-                        olc::net::message<CustomMsgTypes> historyMsg2;
-                        historyMsg2.header.id = CustomMsgTypes::ChatHistoryResponse;
-                        historyMsg2 << senderUserID; // ID of the chat partner
+        // Extract the recipient user ID (the one who sent the request)
+        uint32_t recipientUserID = 0;
+        msg >> recipientUserID;
 
-                        uint32_t historySize2 = static_cast<uint32_t>(formattedHistory.size());
-                        historyMsg2 << historySize2;
-                        for (const char& c : formattedHistory) {
-                            historyMsg2 << c;
-                        }
-                        recipient->send(historyMsg2);
+        // Extract the response (accept/decline)
+        bool accepted = false;
+        msg >> accepted;
 
-                        std::cout << "[SERVER] Chat history automatically sent to both users (size: " << historySize1 << " bytes)\n";
-                    }
-                    else {
-                        std::cout << "[SERVER] No chat history found between " << senderUsername << " and " << recipientUsername << "\n";
-
-                        // Send empty history notification
-                        std::string emptyHistory = "\n=== CHAT HISTORY ===\nNo previous messages found.\n=== END OF HISTORY ===\n";
-
-                        olc::net::message<CustomMsgTypes> emptyMsg1;
-                        emptyMsg1.header.id = CustomMsgTypes::ChatHistoryResponse;
-                        emptyMsg1 << recipientUserID;
-                        uint32_t emptySize = static_cast<uint32_t>(emptyHistory.size());
-                        emptyMsg1 << emptySize;
-                        for (const char& c : emptyHistory) {
-                            emptyMsg1 << c;
-                        }
-                        client->send(emptyMsg1);
-
-                        olc::net::message<CustomMsgTypes> emptyMsg2;
-                        emptyMsg2.header.id = CustomMsgTypes::ChatHistoryResponse;
-                        emptyMsg2 << senderUserID;
-                        emptyMsg2 << emptySize;
-                        for (const char& c : emptyHistory) {
-                            emptyMsg2 << c;
-                        }
-                        recipient->send(emptyMsg2);
-                    }
-                }
+        LOG_INFO("[SERVER] User " << senderUsername
+            << " responded to chat request from UserID #" << recipientUserID
+            << " with answer: " << (accepted ? "ACCEPTED" : "DECLINED"));
+
+        // Find the recipient client (the one who sent the request)
+        std::string recipientUsername;
+        auto recipient = findUserConnection(recipientUserID, recipientUsername);
 
-                // Send confirmation message to the responder
-                if (accepted) {
-                    SendMessageToClient(client, "You accepted chat request from " + recipientUsername);
+        if (recipient != nullptr && recipient->isConnected()) {
+            // Create response message for the original requester
+            olc::net::message<CustomMsgTypes> chatResponseMsg;
+            chatResponseMsg.header.id = CustomMsgTypes::ChatResponse;
+
+            // Add the sender's user ID (the one who accepted/declined)
+            uint32_t senderUserID = userManager.getUserID(senderUsername);
+            chatResponseMsg << senderUserID;
+
+            // Add the response status
+            chatResponseMsg << accepted;
+
+            // Send the response to the recipient
+            recipient->send(chatResponseMsg);
+            LOG_DEBUG("[SERVER] Chat response forwarded to user " << recipientUsername
+                << " (UserID #" << recipientUserID << ")");
+
+            // If accepted, automatically send the newest page of chat history to both users
+            if (accepted) {
+                HistoryPage page;
+                if (loadChatHistory(senderUsername, recipientUsername, CHAT_HISTORY_LATEST, CHAT_HISTORY_PAGE_SIZE, page)) {
+                    // The responder's chat partner is the original requester and vice versa
+                    sendChatHistory(client, recipientUserID, page);
+                    sendChatHistory(recipient, senderUserID, page);
+
+                    LOG_INFO("[SERVER] Chat history automatically sent to both users (" << page.count
+                        << " messages, " << page.entries.size() << " bytes)");
                 }
                 else {
-                    SendMessageToClient(client, "You declined chat request from " + recipientUsername);
+                    SendMessageToClient(client, "Error: Unable to load chat history");
+                    SendMessageToClient(recipient, "Error: Unable to load chat history");
                 }
             }
+
+            // Send confirmation message to the responder
+            if (accepted) {
+                SendMessageToClient(client, "You accepted chat request from " + recipientUsername);
+            }
             else {
-                // Recipient not found or offline
-                SendMessageToClient(client, "Error: User with ID #" + std::to_string(recipientUserID) + " not found or offline");
-                std::cout << "[SERVER] Failed to forward chat response: UserID #" << recipientUserID << " not found or offline\n";
+                SendMessageToClient(client, "You declined chat request from " + recipientUsername);
             }
         }
-        break;
+        else {
+            // Recipient not found or offline
+            SendMessageToClient(client, "Error: User with ID #" + std::to_string(recipientUserID) + " not found or offline");
+            LOG_INFO("[SERVER] Failed to forward chat response: UserID #" << recipientUserID << " not found or offline");
+        }
+    }
 
-        case CustomMsgTypes::ChatHistoryRequest:
-        {
-            std::cout << "[SERVER] Processing ChatHistoryRequest from client ID=" << client->getID() << "\n";
+    // Sends one page of the formatted private chat history with another user
+    void handleChatHistoryRequest(std::shared_ptr<olc::net::connection<CustomMsgTypes>> client, olc::net::message<CustomMsgTypes>& msg)
+    {
+        LOG_DEBUG("[SERVER] Processing ChatHistoryRequest from client ID=" << client->getID());
 
-            // Check if the requester is authenticated
-            std::string requesterUsername;
-            bool requesterAuthenticated = false;
+        // Check if the requester is authenticated
+        std::string requesterUsername;
+        bool requesterAuthenticated = false;
 
-            {
-                std::lock_guard<std::mutex> lock(authMutex);
-                auto it = authenticatedUsers.find(client->getID());
-                if (it != authenticatedUsers.end()) {
-                    requesterUsername = it->second;
-                    requesterAuthenticated = true;
-                }
+        {
+            std::lock_guard<std::mutex> lock(authMutex);
+            auto it = authenticatedUsers.find(client->getID());
+            if (it != authenticatedUsers.end()) {
+                requesterUsername = it->second;
+                requesterAuthenticated = true;
             }
+        }
 
-            if (!requesterAuthenticated) {
-                SendMessageToClient(client, "Error: You must be logged in to request chat history");
-                break;
-            }
+        if (!requesterAuthenticated) {
+            SendMessageToClient(client, "Error: You must be logged in to request chat history");
+            return;
+        }
 
-            // Extract the other user's ID whose chat history is requested
-            uint32_t otherUserID = 0;
-            msg >> otherUserID;
+        // Extract the other user's ID whose chat history is requested
+        uint32_t otherUserID = 0;
+        msg >> otherUserID;
 
-            std::cout << "[SERVER] User " << requesterUsername
-                << " requested chat history with UserID #" << otherUserID << "\n";
+        // Optional cursor and page size; a bare request gets the newest page
+        uint32_t beforeSeq = CHAT_HISTORY_LATEST;
+        uint32_t limit = CHAT_HISTORY_PAGE_SIZE;
+        if (msg.readPos + 2 * sizeof(uint32_t) <= msg.body.size()) {
+            msg >> beforeSeq >> limit;
+            limit = std::clamp<uint32_t>(limit, 1, CHAT_HISTORY_MAX_PAGE_SIZE);
+        }
 
-            // Get the other user's username by their ID
-            std::string otherUsername = userManager.getUsernameByID(otherUserID);
+        LOG_DEBUG("[SERVER] User " << requesterUsername
+            << " requested chat history with UserID #" << otherUserID
+            << " (before #" << beforeSeq << ", limit " << limit << ")");
 
-            if (otherUsername.empty()) {
-                SendMessageToClient(client, "Error: User with ID #" + std::to_string(otherUserID) + " not found");
-                std::cout << "[SERVER] UserID #" << otherUserID << " not found in database\n";
-                break;
-            }
+        // Get the other user's username by their ID
+        std::string otherUsername = userManager.getUsernameByID(otherUserID);
 
-            // Load and format chat history
-            std::string rawChatHistory = loadChatHistory(requesterUsername, otherUsername);
-            std::string formattedHistory = formatChatHistory(rawChatHistory);
+        if (otherUsername.empty()) {
+            SendMessageToClient(client, "Error: User with ID #" + std::to_string(otherUserID) + " not found");
+            LOG_INFO("[SERVER] UserID #" << otherUserID << " not found in database");
+            return;
+        }
 
-            // Create response message
-            olc::net::message<CustomMsgTypes> historyResponse;
-            historyResponse.header.id = CustomMsgTypes::ChatHistoryResponse;
+        // Load the requested page of chat history as encoded entries
+        HistoryPage page;
+        if (!loadChatHistory(requesterUsername, otherUsername, beforeSeq, limit, page)) {
+            SendMessageToClient(client, "Error: Unable to load chat history");
+            return;
+        }
 
-            // Add the other user's ID (chat partner)
-            historyResponse << otherUserID;
+        // Send history to the requester
+        sendChatHistory(client, otherUserID, page);
 
-            // Add the formatted history size and content
-            uint32_t historySize = static_cast<uint32_t>(formattedHistory.size());
-            historyResponse << historySize;
+        LOG_DEBUG("[SERVER] Chat history sent to " << requesterUsername << " with " << otherUsername
+            << " (" << page.count << " messages, " << page.entries.size() << " bytes)");
+    }
 
-            for (const char& c : formattedHistory) {
-                historyResponse << c;
-            }
+    // Saves a private message and delivers it to the recipient
+    void handleDirectMessage(std::shared_ptr<olc::net::connection<CustomMsgTypes>> client, olc::net::message<CustomMsgTypes>& msg)
+    {
+        // Check if the sender is authenticated
+        std::string senderUsername;
+        bool senderAuthenticated = false;
 
-            // Send history to the requester
-            client->send(historyResponse);
+        {
+            std::lock_guard<std::mutex> lock(authMutex);
+            auto it = authenticatedUsers.find(client->getID());
+            if (it != authenticatedUsers.end()) {
+                senderUsername = it->second;
+                senderAuthenticated = true;
+            }
+        }
 
-            std::cout << "[SERVER] Formatted chat history sent to " << requesterUsername
-                << " with " << otherUsername << " (size: " << historySize << " bytes)\n";
+        if (!senderAuthenticated) {
+            SendMessageToClient(client, "Error: You must be logged in to send private messages");
+            return;
         }
-        break;
-        case CustomMsgTypes::DirectMessage:
-        {
-            // Check if the sender is authenticated
-            std::string senderUsername;
-            bool senderAuthenticated = false;
 
-            {
-                std::lock_guard<std::mutex> lock(authMutex);
-                auto it = authenticatedUsers.find(client->getID());
-                if (it != authenticatedUsers.end()) {
-                    senderUsername = it->second;
-                    senderAuthenticated = true;
-                }
-            }
+        // Get the sender's user ID
+        uint32_t senderUserID = userManager.getUserID(senderUsername);
 
-            if (!senderAuthenticated) {
-                SendMessageToClient(client, "Error: You must be logged in to send private messages");
-                break;
-            }
+        // Extract recipient's user ID
+        uint32_t recipientUserID = 0;
+        msg >> recipientUserID;
 
-            // Get the sender's user ID
-            uint32_t senderUserID = userManager.getUserID(senderUsername);
+        // Read the length-prefixed message content
+        std::string messageText;
+        if (!msg.readString(messageText, MAX_CHAT_TEXT_SIZE)) { // Size limit check
+            LOG_WARN("[SERVER] Invalid or too large direct message");
+            return;
+        }
 
-            // Extract recipient's user ID
-            uint32_t recipientUserID = 0;
-            msg >> recipientUserID;
+        LOG_DEBUG("[SERVER] User " << senderUsername
+            << " sent direct message to UserID #" << recipientUserID
+            << ": " << messageText);
+
+        // Find the recipient client by their user ID
+        std::string recipientUsername;
+        auto recipient = findUserConnection(recipientUserID, recipientUsername);
+        if (recipient != nullptr && recipient->isConnected()) {
+            // Save the message to chat history database
+            // The sender is only told if the write fails; forwarding does not wait for the disk
+            saveChatMessage(senderUsername, senderUserID, recipientUsername, recipientUserID, messageText,
+                [this, client, recipientUsername](bool durable) {
+                    if (!durable) {
+                        SendMessageToClient(client, "Warning: your message to " + recipientUsername + " could not be saved to chat history");
+                    }
+                });
 
-            // Extract message size
-            uint32_t messageSize = 0;
-            msg >> messageSize;
+            // Create new message for the recipient
+            olc::net::message<CustomMsgTypes> directMsg;
+            directMsg.header.id = CustomMsgTypes::DirectMessage;
 
-            if (messageSize > 10000) { // Size limit check
-                std::cerr << "[SERVER] Direct message size too large: " << messageSize << std::endl;
-                break;
-            }
+            // Add sender's user ID (required for recipient to identify sender)
+            directMsg << senderUserID;
 
-            // Read the message content
-            std::string messageText;
-            messageText.reserve(messageSize);
-            for (uint32_t i = 0; i < messageSize; i++) {
-                char c;
-                msg >> c;
-                messageText.push_back(c);
-            }
+            // Pack message text size and content
+            directMsg << messageText;
 
-            std::cout << "[SERVER] User " << senderUsername
-                << " sent direct message to UserID #" << recipientUserID
-                << ": " << messageText << "\n";
+            // Send the message to recipient
+            recipient->send(directMsg);
+            LOG_DEBUG("[SERVER] Direct message forwarded to user " << recipientUsername
+                << " (UserID #" << recipientUserID << ")");
 
-            // Find the recipient client by their user ID
-            std::shared_ptr<olc::net::connection<CustomMsgTypes>> recipient = nullptr;
-            std::string recipientUsername;
+            // Confirm delivery to sender
+            SendMessageToClient(client, "Your message has been delivered to " + recipientUsername);
+        }
+        else {
+            // Recipient not found or offline
+            SendMessageToClient(client, "Error: User with ID #" + std::to_string(recipientUserID) + " not found or offline");
+            LOG_INFO("[SERVER] Failed to forward message: UserID #" << recipientUserID << " not found or offline");
+        }
+    }
 
-            {
-                std::lock_guard<std::mutex> lock(authMutex);
+    // Sends the list of connected clients to the requester
+    void handleRequestClientList(std::shared_ptr<olc::net::connection<CustomMsgTypes>> client, [[maybe_unused]] olc::net::message<CustomMsgTypes>& msg)
+    {
+        LOG_DEBUG("[SERVER] Client #" << client->getID() << " requested client list");
 
-                // Find the authenticated user whose userID matches recipientUserID
-                for (auto it = authenticatedUsers.begin(); it != authenticatedUsers.end(); ++it) {
-                    uint32_t clientID = it->first;
-                    std::string username = it->second;
+        // Build list of all connected clients
+        std::string clientList = "Connected clients:";
 
-                    uint32_t userID = userManager.getUserID(username);
-                    if (userID == recipientUserID) {
-                        recipient = getClientByID(clientID);
-                        recipientUsername = username;
-                        break;
-                    }
-                }
-            }
-if (recipient != nullptr && recipient->isConnected()) {
-                // Save the message to chat history database
-                saveChatMessage(senderUsername, senderUserID, recipientUsername, recipientUserID, messageText);
-
-                // Create new message for the recipient
-                olc::net::message<CustomMsgTypes> directMsg;
-                directMsg.header.id = CustomMsgTypes::DirectMessage;
-
-                // Add sender's user ID (required for recipient to identify sender)
-                directMsg << senderUserID;
-
-                // Pack message text size and content
-                uint32_t fullSize = static_cast<uint32_t>(messageText.size());
-                directMsg << fullSize;
-                for (const char& c : messageText) {
-                    directMsg << c;
-                }
+        // Thread-safe access to authenticated users list
+        std::lock_guard<std::mutex> lock(authMutex);
 
-                // Send the message to recipient
-                recipient->send(directMsg);
-                std::cout << "[SERVER] Direct message forwarded to user " << recipientUsername
-                    << " (UserID #" << recipientUserID << ")\n";
+        // Iterate through all active connections
+        for (auto& conn : getAllClients()) {
+            if (conn && conn->isConnected()) {
+                uint32_t connID = conn->getID();
+                std::string info = " #" + std::to_string(connID);
 
-                // Confirm delivery to sender
-                SendMessageToClient(client, "Your message has been delivered to " + recipientUsername);
-            }
-            else {
-                // Recipient not found or offline
-                SendMessageToClient(client, "Error: User with ID #" + std::to_string(recipientUserID) + " not found or offline");
-                std::cout << "[SERVER] Failed to forward message: UserID #" << recipientUserID << " not found or offline\n";
+                // Add username if client is authenticated
+                auto it = authenticatedUsers.find(connID);
+                if (it != authenticatedUsers.end()) {
+                    info += " (" + it->second + ")";
+                }
+
+                clientList += info + ",";
             }
         }
-        break;
-
 
-        case CustomMsgTypes::RequestClientList:
-        {
-            std::cout << "[SERVER] Client #" << client->getID() << " requested client list\n";
+        // Remove trailing comma if present
+        if (clientList.back() == ',') {
+            clientList.pop_back();
+        }
 
-            // Build list of all connected clients
-            std::string clientList = "Connected clients:";
+        LOG_DEBUG("[SERVER] Sending client list to client #" << client->getID() << ": " << clientList);
 
-            // Thread-safe access to authenticated users list
-            std::lock_guard<std::mutex> lock(authMutex);
+        // Send the client list back to requester
+        // The list is presence information, stale as soon as a newer one exists: a congested client keeps only
+        // the newest queued list (or none, depending on the slow-consumer policy) and can simply ask again
+        olc::net::message<CustomMsgTypes> response;
+        response.header.id = CustomMsgTypes::ServerMessage;
+        response << clientList;
+        client->send(olc::net::make_shared_frame(response, olc::net::frame_delivery::ephemeral,
+            static_cast<uint32_t>(CustomMsgTypes::RequestClientList)));
+    }
 
-            // Iterate through all active connections
-            for (auto& conn : getAllClients()) {
-                if (conn && conn->isConnected()) {
-                    uint32_t connID = conn->getID();
-                    std::string info = " #" + std::to_string(connID);
+    // Registers a new user, or logs in an existing one with matching credentials
+    void handleRegisterRequest(std::shared_ptr<olc::net::connection<CustomMsgTypes>> client, olc::net::message<CustomMsgTypes>& msg)
+    {
+        LOG_DEBUG("[SERVER] Processing RegisterRequest from client ID=" << client->getID());
+        // Extract username, password and email from message (size limits for security)
+        std::string username;
+        std::string password;
+        std::string email;
+        if (!msg.readString(username, MAX_CREDENTIAL_SIZE) || !msg.readString(password, MAX_CREDENTIAL_SIZE) || !msg.readString(email, MAX_CREDENTIAL_SIZE)) {
+            LOG_WARN("[SERVER] Malformed RegisterRequest from client ID=" << client->getID());
+            return;
+        }
+        LOG_INFO("[SERVER] Registration/Login attempt for username: " << username << ", email: " << email);
 
-                    // Add username if client is authenticated
-                    auto it = authenticatedUsers.find(connID);
-                    if (it != authenticatedUsers.end()) {
-                        info += " (" + it->second + ")";
-                    }
+        // Check if user already exists in database
+        bool userExists = userManager.doesUserExist(username);
+        bool success = false;
+        std::string responseMessage;
+        std::string usernameError;
 
-                    clientList += info + ",";
-                }
+        // Check if user is already logged in from another client
+        bool userOnline = false;
+        uint32_t existingClientID = 0;
+        {
+            std::lock_guard<std::mutex> lock(authMutex);
+            auto it = userToClientMap.find(username);
+            if (it != userToClientMap.end()) {
+                userOnline = true;
+                existingClientID = it->second;
             }
+        }
 
-            // Remove trailing comma if present
-            if (clientList.back() == ',') {
-                clientList.pop_back();
-            }
+        if (userExists) {
+            // User exists - attempt login with provided credentials
+            success = userManager.authenticateUser(username, password);
 
-            std::cout << "[SERVER] Sending client list to client #" << client->getID() << ": " << clientList << "\n";
+            if (success) {
+                if (userOnline) {
+                    // Handle multiple login scenario - disconnect previous session
+                    responseMessage = "User " + username + " is already authorized from another client (#" +
+                        std::to_string(existingClientID) + "). Previous session will be terminated.";
+                    LOG_INFO("[SERVER] User " << username << " is already online. Handling multiple login.");
 
-            // Send the client list back to requester
-            SendMessageToClient(client, clientList);
-        }
-        break;
+                    // Prepare response message before disconnecting previous client
+                    olc::net::message<CustomMsgTypes> response;
+                    response.header.id = CustomMsgTypes::RegisterResponse;
+                    response << success;
 
-        case CustomMsgTypes::RegisterRequest:
-        {
-            std::cout << "[SERVER] Processing RegisterRequest from client ID=" << client->getID() << "\n";
-            // Extract username from message
-            uint32_t usernameSize = 0;
-            msg >> usernameSize;
-            std::string username;
-            for (uint32_t i = 0; i < usernameSize && i < 100; i++) { // Username size limit for security
-                char c;
-                msg >> c;
-                username.push_back(c);
-            }
-            // Extract password from message
-            uint32_t passwordSize = 0;
-            msg >> passwordSize;
-            std::string password;
-            for (uint32_t i = 0; i < passwordSize && i < 100; i++) { // Password size limit for security
-                char c;
-                msg >> c;
-                password.push_back(c);
-            }
-            // Extract email from message
-            uint32_t emailSize = 0;
-            msg >> emailSize;
-            std::string email;
-            for (uint32_t i = 0; i < emailSize && i < 100; i++) { // Email size limit for security
-                char c;
-                msg >> c;
-                email.push_back(c);
-            }
-            std::cout << "[SERVER] Registration/Login attempt for username: " << username << ", email: " << email << "\n";
+                    // Pack response message
+                    response << responseMessage;
 
-            // Check if user already exists in database
-            bool userExists = userManager.doesUserExist(username);
-            bool success = false;
-            std::string responseMessage;
+                    // Send response to new client attempting to login
+                    client->send(response);
 
-            // Check if user is already logged in from another client
-            bool userOnline = false;
-            uint32_t existingClientID = 0;
-            {
-                std::lock_guard<std::mutex> lock(authMutex);
-                auto it = userToClientMap.find(username);
-                if (it != userToClientMap.end()) {
-                    userOnline = true;
-                    existingClientID = it->second;
-                }
-            }
+                    // Get or assign permanent user ID
+                    uint32_t userID = userManager.getUserID(username);
+                    if (userID == 0) {
+                        // Assign new permanent ID if user doesn't have one yet
+                        userID = userManager.assignUserID(username);
+                    }
 
-            if (userExists) {
-                // User exists - attempt login with provided credentials
-                success = userManager.authenticateUser(username, password);
-
-                if (success) {
-                    if (userOnline) {
-                        // Handle multiple login scenario - disconnect previous session
-                        responseMessage = "User " + username + " is already authorized from another client (#" +
-                            std::to_string(existingClientID) + "). Previous session will be terminated.";
-                        std::cout << "[SERVER] User " << username << " is already online. Handling multiple login." << "\n";
-
-                        // Prepare response message before disconnecting previous client
-                        olc::net::message<CustomMsgTypes> response;
-                        response.header.id = CustomMsgTypes::RegisterResponse;
-                        response << success;
-
-                        // Pack response message
-                        uint32_t messageSize = static_cast<uint32_t>(responseMessage.size());
-                        response << messageSize;
-                        for (const char& c : responseMessage) {
-                            response << c;
-                        }
+                    // Update authentication mappings with thread safety
+                    {
+                        std::lock_guard<std::mutex> lock(authMutex);
+                        authenticatedUsers[client->getID()] = username;
+                        userToClientMap[username] = client->getID();
+                        addUserRoute(userID, username, client);
+                    }
 
-                        // Send response to new client attempting to login
-                        client->send(response);
+                    // Send permanent user ID to authenticated client
+                    olc::net::message<CustomMsgTypes> idMsg;
+                    idMsg.header.id = CustomMsgTypes::ServerAccept;
+                    idMsg << userID;
+                    client->send(idMsg);
 
-                        // Get or assign permanent user ID
-                        uint32_t userID = userManager.getUserID(username);
-                        if (userID == 0) {
-                            // Assign new permanent ID if user doesn't have one yet
-                            userID = userManager.assignUserID(username);
-                        }
+                    LOG_INFO("[SERVER] User " << username << " authenticated with permanent ID=" << userID);
+
+                    // Find and disconnect the previous client session
+                    auto oldClient = getClientByID(existingClientID);
+                    if (oldClient && oldClient->isConnected()) {
+                        SendMessageToClient(oldClient, "You have been disconnected because your account was opened from another device");
+                        LOG_INFO("[SERVER] Sending notification to client #" << existingClientID << " about new login");
 
-                        // Update authentication mappings with thread safety
+                        // Clean up authentication data for old client
                         {
                             std::lock_guard<std::mutex> lock(authMutex);
-                            authenticatedUsers[client->getID()] = username;
-                            userToClientMap[username] = client->getID();
+                            authenticatedUsers.erase(existingClientID);
                         }
 
-                        // Send permanent user ID to authenticated client
-                        olc::net::message<CustomMsgTypes> idMsg;
-                        idMsg.header.id = CustomMsgTypes::ServerAccept;
-                        idMsg << userID;
-                        client->send(idMsg);
-
-                        std::cout << "[SERVER] User " << username << " authenticated with permanent ID=" << userID << "\n";
-
-                        // Find and disconnect the previous client session
-                        auto oldClient = getClientByID(existingClientID);
-                        if (oldClient && oldClient->isConnected()) {
-                            SendMessageToClient(oldClient, "You have been disconnected because your account was opened from another device");
-                            std::cout << "[SERVER] Sending notification to client #" << existingClientID << " about new login" << "\n";
-
-                            // Clean up authentication data for old client
-                            {
-                                std::lock_guard<std::mutex> lock(authMutex);
-                                authenticatedUsers.erase(existingClientID);
-                            }
-
-                            // Safely disconnect old client in separate thread to avoid blocking
-                            std::thread([this, existingClientID]() {
-                                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                                auto client = this->getClientByID(existingClientID);
-                                if (client) {
-                                    this->removeClient(client);
-                                }
-                                }).detach();
-                        }
-
-                        // Response already sent, exit handler
-                        break;
-                    }
-                    else {
-                        // Single login scenario - user authenticated successfully
-                        responseMessage = "User already exists. Automatic login performed. Welcome, " + username + "!";
+                        // Disconnect the old client shortly, once the notification had a chance to go out
+                        removeClientAfter(existingClientID, std::chrono::milliseconds(100));
                     }
-                    std::cout << "[SERVER] User " << username << " exists. Auto-login successful." << "\n";
+
+                    // Response already sent, exit handler
+                    return;
                 }
                 else {
-                    // Authentication failed - wrong password
-                    responseMessage = "User already exists, but password is incorrect. Please try again.";
-                    std::cout << "[SERVER] User " << username << " exists but authentication failed." << "\n";
+                    // Single login scenario - user authenticated successfully
+                    responseMessage = "User already exists. Automatic login performed. Welcome, " + username + "!";
                 }
+                LOG_INFO("[SERVER] User " << username << " exists. Auto-login successful.");
             }
             else {
-                // User doesn't exist - proceed with registration
-                // Create new user object
-                User newUser;
-                newUser.username = username;
-                newUser.password_hash = userManager.hashPassword(password);
-                newUser.email = email;
-
-                // Get current timestamp for registration date
-                auto now = std::chrono::system_clock::now();
-                time_t time_now = std::chrono::system_clock::to_time_t(now);
-                char timeStr[100];
-                struct tm timeinfo;
-
-                // Use thread-safe time conversion
+                // Authentication failed - wrong password
+                responseMessage = "User already exists, but password is incorrect. Please try again.";
+                LOG_WARN("[SERVER] User " << username << " exists but authentication failed.");
+            }
+        }
+        else if (!client->validateUsername(username, usernameError)) {
+            // Reserved (e.g. "admin") or malformed names cannot be registered
+            responseMessage = "Registration failed: " + usernameError;
+            LOG_WARN("[SERVER] Rejected registration of username " << username << ": " << usernameError);
+        }
+        else {
+            // User doesn't exist - proceed with registration
+            // Create new user object
+            User newUser;
+            newUser.username = username;
+            newUser.password_hash = userManager.hashPassword(password);
+            newUser.email = email;
+
+            // Get current timestamp for registration date
+            auto now = std::chrono::system_clock::now();
+            time_t time_now = std::chrono::system_clock::to_time_t(now);
+            char timeStr[100];
+            struct tm timeinfo;
+
+            // Use thread-safe time conversion
 #ifdef _WIN32
-                localtime_s(&timeinfo, &time_now);  // Windows secure version
+            localtime_s(&timeinfo, &time_now);  // Windows secure version
 #else
-                localtime_r(&time_now, &timeinfo);  // POSIX thread-safe version
+            localtime_r(&time_now, &timeinfo);  // POSIX thread-safe version
 #endif
 
-                std::strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &timeinfo);
-                newUser.registration_date = timeStr;
+            std::strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &timeinfo);
+            newUser.registration_date = timeStr;
 
-                // Attempt to register new user in database
-                success = userManager.registerUser(newUser);
-                responseMessage = success ?
-                    "Registration successful. Welcome, " + username + "!" :
-                    "Registration failed. Please try again.";
-            }
+            // Attempt to register new user in database
+            success = userManager.registerUser(newUser);
+            responseMessage = success ?
+                "Registration successful. Welcome, " + username + "!" :
+                "Registration failed. Please try again.";
+        }
 
-            // Prepare response message for client
-            olc::net::message<CustomMsgTypes> response;
-            response.header.id = CustomMsgTypes::RegisterResponse;
+        // Prepare response message for client
+        olc::net::message<CustomMsgTypes> response;
+        response.header.id = CustomMsgTypes::RegisterResponse;
 
-            // Add success/failure flag
-            response << success;
+        // Add success/failure flag
+        response << success;
 
-            // Pack response message text
-            uint32_t messageSize = static_cast<uint32_t>(responseMessage.size());
-            response << messageSize;
-            for (const char& c : responseMessage) {
-                response << c;
-            }
+        // Pack response message text
+        response << responseMessage;
 
-            // Send response back to client
-            client->send(response);
+        // Send response back to client
+        client->send(response);
 
-            // Rest of code for handling successful registration/login...
-            // (leave as was)
-        }
-        break;
-case CustomMsgTypes::LoginRequest:
-        {
-            std::cout << "[SERVER] Processing LoginRequest from client ID=" << client->getID() << "\n";
-
-            // Extract username size from message
-            uint32_t usernameSize = 0;
-            msg >> usernameSize;
-
-            // Read username character by character
-            std::string username;
-            for (uint32_t i = 0; i < usernameSize; i++) {
-                char c;
-                msg >> c;
-                username.push_back(c);
-            }
+        // Rest of code for handling successful registration/login...
+        // (leave as was)
+    }
 
-            // Extract password size from message
-            uint32_t passwordSize = 0;
-            msg >> passwordSize;
+    // Authenticates a user, replacing any previous session of the same account
+    void handleLoginRequest(std::shared_ptr<olc::net::connection<CustomMsgTypes>> client, olc::net::message<CustomMsgTypes>& msg)
+    {
+        LOG_DEBUG("[SERVER] Processing LoginRequest from client ID=" << client->getID());
 
-            // Read password character by character
-            std::string password;
-            for (uint32_t i = 0; i < passwordSize; i++) {
-                char c;
-                msg >> c;
-                password.push_back(c);
-            }
+        // Extract length-prefixed username and password from message
+        std::string username;
+        std::string password;
+        if (!msg.readString(username, MAX_CREDENTIAL_SIZE) || !msg.readString(password, MAX_CREDENTIAL_SIZE)) {
+            LOG_WARN("[SERVER] Malformed LoginRequest from client ID=" << client->getID());
+            return;
+        }
 
-            std::cout << "[SERVER] Login attempt for username: " << username << "\n";
+        LOG_INFO("[SERVER] Login attempt for username: " << username);
 
-            // Check if user is already logged in from another client
-            bool userOnline = false;
-            uint32_t existingClientID = 0;
-            {
-                std::lock_guard<std::mutex> lock(authMutex);
-                auto it = userToClientMap.find(username);
-                if (it != userToClientMap.end()) {
-                    userOnline = true;
-                    existingClientID = it->second;
-                }
+        // Check if user is already logged in from another client
+        bool userOnline = false;
+        uint32_t existingClientID = 0;
+        {
+            std::lock_guard<std::mutex> lock(authMutex);
+            auto it = userToClientMap.find(username);
+            if (it != userToClientMap.end()) {
+                userOnline = true;
+                existingClientID = it->second;
             }
+        }
 
-            // Verify user credentials with user manager
-            bool success = userManager.authenticateUser(username, password);
-            std::string responseMessage;
+        // Verify user credentials with user manager
+        bool success = userManager.authenticateUser(username, password);
+        std::string responseMessage;
 
-            if (success && userOnline) {
-                responseMessage = "User " + username + " already logged in from another client (#" +
-                    std::to_string(existingClientID) + "). Previous session will be terminated.";
-                std::cout << "[SERVER] Existing session detected for " << username << ", Client #" << existingClientID << "\n";
+        if (success && userOnline) {
+            responseMessage = "User " + username + " already logged in from another client (#" +
+                std::to_string(existingClientID) + "). Previous session will be terminated.";
+            LOG_INFO("[SERVER] Existing session detected for " << username << ", Client #" << existingClientID);
 
-                // Locate and disconnect the previous client session
-                auto oldClient = getClientByID(existingClientID);
-                if (oldClient && oldClient->isConnected()) {
-                    SendMessageToClient(oldClient, "You have been disconnected because your account was opened from another device");
-                    std::cout << "[SERVER] Sending notification to client #" << existingClientID << " about new login" << "\n";
+            // Locate and disconnect the previous client session
+            auto oldClient = getClientByID(existingClientID);
+            if (oldClient && oldClient->isConnected()) {
+                SendMessageToClient(oldClient, "You have been disconnected because your account was opened from another device");
+                LOG_INFO("[SERVER] Sending notification to client #" << existingClientID << " about new login");
 
-                    // Remove authentication data for the old client
-                    {
-                        std::lock_guard<std::mutex> lock(authMutex);
-                        authenticatedUsers.erase(existingClientID);
-                        userToClientMap.erase(username);
-                    }
-
-                    // Asynchronously remove the old client after a short delay
-                    std::thread([this, existingClientID]() {
-                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                        auto client = this->getClientByID(existingClientID);
-                        if (client) {
-                            this->removeClient(client);
-                        }
-                        }).detach();
+                // Remove authentication data for the old client
+                {
+                    std::lock_guard<std::mutex> lock(authMutex);
+                    authenticatedUsers.erase(existingClientID);
+                    userToClientMap.erase(username);
                 }
+
+                // Remove the old client after a short delay
+                removeClientAfter(existingClientID, std::chrono::milliseconds(100));
             }
-            else if (success) {
-                responseMessage = "Login successful. Welcome back, " + username + "!";
-            }
-            else {
-                responseMessage = "Login failed. Invalid username or password.";
-            }
+        }
+        else if (success) {
+            responseMessage = "Login successful. Welcome back, " + username + "!";
+        }
+        else {
+            responseMessage = "Login failed. Invalid username or password.";
+        }
 
-            // Prepare login response message
-            olc::net::message<CustomMsgTypes> response;
-            response.header.id = CustomMsgTypes::LoginResponse;
+        // Prepare login response message
+        olc::net::message<CustomMsgTypes> response;
+        response.header.id = CustomMsgTypes::LoginResponse;
 
-            // Add success flag to response
-            response << success;
+        // Add success flag to response
+        response << success;
 
-            // Add response message size and content
-            uint32_t messageSize = static_cast<uint32_t>(responseMessage.size());
-            response << messageSize;
+        // Add response message size and content
+        response << responseMessage;
 
-            for (const char& c : responseMessage) {
-                response << c;
-            }
+        // Send login response to client
+        client->send(response);
 
-            // Send login response to client
-            client->send(response);
+        if (success) {
+            // Retrieve user's permanent ID from user manager
+            uint32_t userID = userManager.getUserID(username);
 
-            if (success) {
-                // Update authentication mappings with thread safety
-                {
-                    std::lock_guard<std::mutex> lock(authMutex);
-                    authenticatedUsers[client->getID()] = username;
-                    userToClientMap[username] = client->getID();
-                }
+            // Update authentication mappings with thread safety
+            {
+                std::lock_guard<std::mutex> lock(authMutex);
+                authenticatedUsers[client->getID()] = username;
+                userToClientMap[username] = client->getID();
+                addUserRoute(userID, username, client);
+            }
 
-                // Retrieve user's permanent ID from user manager
-                uint32_t userID = userManager.getUserID(username);
+            // Send permanent user ID to client
+            olc::net::message<CustomMsgTypes> idMsg;
+            idMsg.header.id = CustomMsgTypes::ServerAccept;
+            idMsg << userID;
+            client->send(idMsg);
 
-                // Send permanent user ID to client
-                olc::net::message<CustomMsgTypes> idMsg;
-                idMsg.header.id = CustomMsgTypes::ServerAccept;
-                idMsg << userID;
-                client->send(idMsg);
+            LOG_INFO("[SERVER] User " << username << " logged in with permanent ID=" << userID);
 
-                std::cout << "[SERVER] User " << username << " logged in with permanent ID=" << userID << "\n";
+            // Update user's online status in user manager
+            userManager.setUserOnlineStatus(username, true, client->getID());
 
-                // Update user's online status in user manager
-                userManager.setUserOnlineStatus(username, true, userID);
+            // Notify all other clients about the new user login
+            BroadcastMessage("User " + username + " has logged in", client);
+        }
+    }
+};
 
-                // Notify all other clients about the new user login
-                BroadcastMessage("User " + username + " has logged in", client);
+// Usage: server [--trace-sampling N] [--slow-consumer drop|collapse|disconnect] [--outbound-limits HIGH LOW MAX]
+//               [--fsync none|interval|batch] [--fsync-interval MS]
+//   --trace-sampling N   time one in every N incoming messages stage by stage for the statistics report (default 0 = off)
+//   --slow-consumer P    what happens to ephemeral frames (client lists) for a client above the high watermark:
+//                        dropped, collapsed to the newest one, or the client is disconnected (default collapse)
+//   --outbound-limits HIGH LOW MAX   per-client outgoing queue watermarks and hard limit in bytes
+//   --fsync P            when chat log appends are synced to disk: none (left to the OS), interval (at most every
+//                        --fsync-interval MS milliseconds, default 100) or batch (every group commit) (default interval)
+int main(int argc, char* argv[])
+{
+    // Per-message tracing is compiled in but filtered out; LogLevel::Debug turns it on
+    Logger::instance().setLevel(LogLevel::Info);
+
+    uint32_t nTraceSampling = 0;
+    olc::net::outbound_limits outboundLimits;
+    PersistenceStage::FsyncPolicy fsyncPolicy = PersistenceStage::FsyncPolicy::Interval;
+    uint32_t nSyncIntervalMs = 100;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--trace-sampling" && i + 1 < argc) {
+            nTraceSampling = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--slow-consumer" && i + 1 < argc) {
+            std::string policy = argv[++i];
+            if (policy == "drop") {
+                outboundLimits.policy = olc::net::slow_consumer_policy::drop_ephemeral;
+            }
+            else if (policy == "collapse") {
+                outboundLimits.policy = olc::net::slow_consumer_policy::collapse_ephemeral;
+            }
+            else if (policy == "disconnect") {
+                outboundLimits.policy = olc::net::slow_consumer_policy::disconnect;
+            }
+            else {
+                LOG_WARN("[SERVER] Unknown slow-consumer policy " << policy << ", keeping the default");
             }
         }
-        break;
-
-        default:
-            std::cout << "[SERVER] Unknown message type: " << static_cast<uint32_t>(msg.header.id) << "\n";
-            break;
+        else if (arg == "--outbound-limits" && i + 3 < argc) {
+            outboundLimits.highWatermark = std::strtoull(argv[++i], nullptr, 10);
+            outboundLimits.lowWatermark = std::strtoull(argv[++i], nullptr, 10);
+            outboundLimits.maxQueuedBytes = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--fsync" && i + 1 < argc) {
+            std::string policy = argv[++i];
+            if (policy == "none") {
+                fsyncPolicy = PersistenceStage::FsyncPolicy::None;
+            }
+            else if (policy == "interval") {
+                fsyncPolicy = PersistenceStage::FsyncPolicy::Interval;
+            }
+            else if (policy == "batch") {
+                fsyncPolicy = PersistenceStage::FsyncPolicy::EveryBatch;
+            }
+            else {
+                LOG_WARN("[SERVER] Unknown fsync policy " << policy << ", keeping the default");
+            }
+        }
+        else if (arg == "--fsync-interval" && i + 1 < argc) {
+            nSyncIntervalMs = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else {
+            LOG_WARN("[SERVER] Ignoring unknown argument: " << arg);
         }
     }
-};
 
-int main()
-{
-    std::cout << "[SERVER] Starting on port 60000...\n";
+    if (outboundLimits.lowWatermark > outboundLimits.highWatermark || outboundLimits.highWatermark > outboundLimits.maxQueuedBytes) {
+        LOG_ERROR("[SERVER] Outgoing queue limits must satisfy LOW <= HIGH <= MAX");
+        return -1;
+    }
+
+    LOG_INFO("[SERVER] Starting on port 60000...");
 
     try {
         // Initialize custom server on port 60000
-        CustomServer server(60000);
+        CustomServer server(60000, 0, 0, GlobalChatManager::DEFAULT_HISTORY_CAPACITY, fsyncPolicy, nSyncIntervalMs);
+        server.setTraceSampling(nTraceSampling);
+        server.setOutboundLimits(outboundLimits);
+        if (nTraceSampling > 0) {
+            LOG_INFO("[SERVER] Tracing one in every " << nTraceSampling << " incoming messages");
+        }
 
         // Attempt to start the server
         if (server.start()) {
-            std::cout << "[SERVER] Started successfully!\n";
+            LOG_INFO("[SERVER] Started successfully!");
         }
         else {
-            std::cout << "[SERVER] Failed to start!\n";
+            LOG_ERROR("[SERVER] Failed to start!");
             return -1;
         }
 
-        std::cout << "[SERVER] Entering main loop...\n";
-        std::cout << "[SERVER] Press Ctrl+C to stop server\n";
+        LOG_INFO("[SERVER] Entering main loop...");
+        LOG_INFO("[SERVER] Press Ctrl+C to stop server");
 
-        // Main server event loop
+        // Maximum number of messages dispatched per loop iteration
+        const size_t nDispatchBudget = 256;
+
+        // Main server event loop - blocks only while the incoming queue is empty
         bool running = true;
         while (running) {
             try {
-                // Process all pending messages (-1 = process all, true = wait if queue empty)
-                server.update(-1, true);
-
-                // Small delay to prevent excessive CPU usage
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                server.update(nDispatchBudget, true);
             }
             catch (const std::exception& e) {
-                std::cerr << "[SERVER] Error in main loop: " << e.what() << "\n";
+                LOG_ERROR("[SERVER] Error in main loop: " << e.what());
                 // Continue running despite errors to maintain server stability
             }
         }
 
         // Graceful server shutdown
-        std::cout << "[SERVER] Shutting down...\n";
+        LOG_INFO("[SERVER] Shutting down...");
         server.stop();
     }
     catch (const std::exception& e) {
-        std::cerr << "[SERVER] Fatal error: " << e.what() << "\n";
+        LOG_ERROR("[SERVER] Fatal error: " << e.what());
         return -1;
     }
 
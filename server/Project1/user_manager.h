@@ -1,10 +1,12 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <mutex>
 #include <fstream>
 #include <sstream>
 #include "simdjson.h"
+#include "logger.h"
 
 struct User {
     uint32_t id;         // Unique user ID
@@ -14,9 +16,10 @@ struct User {
     std::string registration_date;
     bool is_online;
     uint32_t client_id;  // ID of the client connection (may be temporary)
+    bool is_admin;       // May request server statistics; only granted by editing the users file
 
     // Default constructor
-    User() : id(0), is_online(false), client_id(10000) {}
+    User() : id(0), is_online(false), client_id(10000), is_admin(false) {}
 };
 
 class UserManager {
@@ -26,6 +29,36 @@ private:
     std::mutex mutex;
     simdjson::dom::parser json_parser;
 
+    // In-memory indexes into the users vector (users are never erased, so indexes stay valid)
+    std::unordered_map<std::string, size_t> usersByName;  // username -> index
+    std::unordered_map<uint32_t, size_t> usersByID;       // user ID -> index
+    std::unordered_map<uint32_t, size_t> usersByClientID; // client ID -> index (online users only)
+
+    // Looks up a user by name, caller must hold mutex
+    User* findUserByName(const std::string& username) {
+        auto it = usersByName.find(username);
+        return it != usersByName.end() ? &users[it->second] : nullptr;
+    }
+
+    // Rebuilds all lookup indexes from the users vector, caller must hold mutex
+    void rebuildIndexes() {
+        usersByName.clear();
+        usersByID.clear();
+        usersByClientID.clear();
+        usersByName.reserve(users.size());
+        usersByID.reserve(users.size());
+
+        for (size_t i = 0; i < users.size(); i++) {
+            usersByName[users[i].username] = i;
+            if (users[i].id != 0) {
+                usersByID[users[i].id] = i;
+            }
+            if (users[i].is_online) {
+                usersByClientID[users[i].client_id] = i;
+            }
+        }
+    }
+
 public:
     // Method to get username by user ID
     std::string getUsernameByID(uint32_t userID);
@@ -39,19 +72,25 @@ public:
     void setUserOnlineStatus(const std::string& username, bool isOnline, uint32_t clientId = 0) {
         std::lock_guard<std::mutex> lock(mutex);
 
-        bool found = false;
-        for (auto& user : users) {
-            if (user.username == username) {
-                user.is_online = isOnline;
-                user.client_id = clientId;
-                found = true;
-                break;
+        User* user = findUserByName(username);
+        if (user) {
+            // Drop the previous client mapping before recording the new one
+            auto it = usersByClientID.find(user->client_id);
+            if (it != usersByClientID.end() && &users[it->second] == user) {
+                usersByClientID.erase(it);
+            }
+
+            user->is_online = isOnline;
+            user->client_id = clientId;
+
+            if (isOnline) {
+                usersByClientID[clientId] = usersByName[username];
             }
         }
 
         // Warning for debugging purposes
-        if (!found) {
-            std::cerr << "[USER_MANAGER] Warning: attempting to set online status for non-existent user: " << username << std::endl;
+        if (!user) {
+            LOG_WARN("[USER_MANAGER] Warning: attempting to set online status for non-existent user: " << username);
         }
     }
     // In user_manager.h, in generateJsonString() method we need to include user ID
@@ -70,7 +109,8 @@ public:
             ss << "      \"username\": \"" << user.username << "\",\n";
             ss << "      \"password_hash\": \"" << user.password_hash << "\",\n";
             ss << "      \"email\": \"" << user.email << "\",\n";
-            ss << "      \"registration_date\": \"" << user.registration_date << "\"\n";
+            ss << "      \"registration_date\": \"" << user.registration_date << "\",\n";
+            ss << "      \"is_admin\": " << (user.is_admin ? "true" : "false") << "\n";
             ss << "    }";
 
             if (i < users.size() - 1) {
@@ -97,86 +137,71 @@ public:
     }
 
     uint32_t getUserID(const std::string& username) {
-        //std::lock_guard<std::mutex> lock(mutex);
-
-        // Load current user data from file
-        loadUsers();
-
-        for (const auto& user : users) {
-            if (user.username == username) {
-                return user.id;
-            }
-        }
+        std::lock_guard<std::mutex> lock(mutex);
 
-        return 0; // User not found
+        const User* user = findUserByName(username);
+        return user ? user->id : 0; // 0 - user not found
     }
 
 
     // Assign user ID
     // In user_manager.h, in UserManager class
     uint32_t assignUserID(const std::string& username) {
-        //std::lock_guard<std::mutex> lock(mutex);
+        std::lock_guard<std::mutex> lock(mutex);
+
+        User* user = findUserByName(username);
+        if (!user) {
+            return 0; // User not found
+        }
 
         // Increment last_user_id for new assignment
         last_user_id++;
 
-        // Assign ID to user
-        for (auto& user : users) {
-            if (user.username == username) {
-                user.id = last_user_id;
-                saveUsers(); // Save changes to file, including updated last_user_id
-                return last_user_id;
-            }
-        }
-
-        return 0; // User not found
+        // Assign ID to user and index it
+        user->id = last_user_id;
+        usersByID[user->id] = usersByName[username];
+        saveUsersLocked(); // Save changes to file, including updated last_user_id
+        return last_user_id;
     }
     void updateUserLastLogin(const std::string& username) {
-        //std::lock_guard<std::mutex> lock(mutex);
-
-        // Load current user data from file
-        loadUsers();
+        std::lock_guard<std::mutex> lock(mutex);
 
-        for (auto& user : users) {
-            if (user.username == username) {
-                // Update last_login field if it exists
-                auto now = std::chrono::system_clock::now();
-                time_t time_now = std::chrono::system_clock::to_time_t(now);
-                char timeStr[100];
-                struct tm timeinfo;
+        User* user = findUserByName(username);
+        if (user) {
+            // Update last_login field if it exists
+            auto now = std::chrono::system_clock::now();
+            time_t time_now = std::chrono::system_clock::to_time_t(now);
+            char timeStr[100];
+            struct tm timeinfo;
 
 #ifdef _WIN32
-                localtime_s(&timeinfo, &time_now);  // Windows version
+            localtime_s(&timeinfo, &time_now);  // Windows version
 #else
-                localtime_r(&time_now, &timeinfo);  // POSIX version
+            localtime_r(&time_now, &timeinfo);  // POSIX version
 #endif
 
-                std::strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &timeinfo);
-                // If we have last_login field:
-                // user.last_login = timeStr;
-                break;
-            }
+            std::strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &timeinfo);
+            // If we have last_login field (no disk write needed until then):
+            // user->last_login = timeStr;
+            // saveUsersLocked();
         }
-
-        // Save updated user data
-        saveUsers();
     }
 
-    bool doesUserExist(const std::string& username) {
-        //std::lock_guard<std::mutex> lock(mutex);
+    // Whether the user holds admin rights
+    bool isAdmin(const std::string& username) {
+        std::lock_guard<std::mutex> lock(mutex);
 
-        // Load current user data from file
-        loadUsers();
+        const User* user = findUserByName(username);
+        return user && user->is_admin;
+    }
 
-        for (const auto& user : users) {
-            if (user.username == username) {
-                return true;
-            }
-        }
+    bool doesUserExist(const std::string& username) {
+        std::lock_guard<std::mutex> lock(mutex);
 
-        return false;
+        return findUserByName(username) != nullptr;
     }
 
+    // Users are read from disk once; afterwards the file is only written for persistence
     UserManager(const std::string& dbFile = "users.json") : database_file(dbFile) {
         loadUsers();
     }
@@ -189,9 +214,9 @@ public:
             std::ifstream file(database_file);
             if (!file.is_open()) {
                 // File doesn't exist, create a new one
-                std::cout << "[USER_MANAGER] Database file not found, creating new one" << std::endl;
+                LOG_INFO("[USER_MANAGER] Database file not found, creating new one");
                 last_user_id = 10000; // Initialize starting value for last_user_id
-                saveUsers();
+                saveUsersLocked();
                 return true;
             }
 
@@ -202,9 +227,9 @@ public:
 // Check if file is empty, create new one
             if (file_size == 0) {
                 file.close();
-                std::cout << "[USER_MANAGER] File is empty, creating new one" << std::endl;
+                LOG_INFO("[USER_MANAGER] File is empty, creating new one");
                 last_user_id = 10000; // Initialize default value for last_user_id
-                saveUsers();
+                saveUsersLocked();
                 return true;
             }
 
@@ -213,7 +238,7 @@ public:
             file.read(&json_str[0], file_size);
             file.close();
 
-            std::cout << "[USER_MANAGER] Loading data from file, size: " << file_size << " bytes" << std::endl;
+            LOG_INFO("[USER_MANAGER] Loading data from file, size: " << file_size << " bytes");
             // Debug output
             // std::cout << "[USER_MANAGER] JSON content: " << json_str << std::endl;
 
@@ -223,26 +248,26 @@ public:
             // Load the last assigned user ID
             // Check if last_user_id field exists in JSON
             if (json["last_user_id"].error() != simdjson::error_code::SUCCESS) {
-                std::cout << "[USER_MANAGER] Warning: last_user_id field not found, using default value" << std::endl;
+                LOG_WARN("[USER_MANAGER] Warning: last_user_id field not found, using default value");
                 last_user_id = 10000;  // Default value
             }
             else {
                 uint64_t loaded_id = 0;
                 auto id_result = json["last_user_id"].get(loaded_id);
                 if (id_result) {
-                    std::cerr << "[USER_MANAGER] Error loading last_user_id: " << id_result << std::endl;
+                    LOG_ERROR("[USER_MANAGER] Error loading last_user_id: " << id_result);
                     last_user_id = 10000;  // Default value on error
                 }
                 else {
                     last_user_id = static_cast<uint32_t>(loaded_id);
-                    std::cout << "[USER_MANAGER] Successfully loaded last_user_id: " << last_user_id << std::endl;
+                    LOG_INFO("[USER_MANAGER] Successfully loaded last_user_id: " << last_user_id);
                 }
             }
 
             auto users_array = json["users"];
 
             if (!users_array.is_array()) {
-                std::cerr << "[USER_MANAGER] Error: 'users' is not an array" << std::endl;
+                LOG_ERROR("[USER_MANAGER] Error: 'users' is not an array");
                 return false;
             }
 
@@ -255,24 +280,24 @@ public:
 
                 // Load user ID with error handling
                 if (user_element["id"].error() != simdjson::error_code::SUCCESS) {
-                    std::cerr << "[USER_MANAGER] Warning: user doesn't have id field" << std::endl;
+                    LOG_WARN("[USER_MANAGER] Warning: user doesn't have id field");
                     user.id = 0; // Default ID
                 }
                 else {
                     uint64_t user_id = 0;
                     auto id_result = user_element["id"].get(user_id);
                     if (id_result) {
-                        std::cerr << "[USER_MANAGER] Error getting user ID: " << id_result << std::endl;
+                        LOG_ERROR("[USER_MANAGER] Error getting user ID: " << id_result);
                         user.id = 0;
                     }
                     else {
                         user.id = static_cast<uint32_t>(user_id);
-                        std::cout << "[USER_MANAGER] Successfully loaded user ID: " << user.id << std::endl;
+                        LOG_DEBUG("[USER_MANAGER] Successfully loaded user ID: " << user.id);
 
                         // Update last_user_id if current user ID is greater than stored last_user_id
                         if (user.id > last_user_id) {
                             last_user_id = user.id;
-                            std::cout << "[USER_MANAGER] Updated last_user_id based on existing user: " << last_user_id << std::endl;
+                            LOG_INFO("[USER_MANAGER] Updated last_user_id based on existing user: " << last_user_id);
                         }
                     }
                 }
@@ -294,23 +319,31 @@ public:
                 user_element["registration_date"].get(registration_date_view);
                 user.registration_date = std::string(registration_date_view);
 
+                // Missing in files written before admin rights existed
+                bool is_admin = false;
+                if (user_element["is_admin"].get(is_admin) == simdjson::error_code::SUCCESS) {
+                    user.is_admin = is_admin;
+                }
+
                 // Debug output
-                std::cout << "[USER_MANAGER] Loaded user: " << user.username
-                    << ", ID=" << user.id << std::endl;
+                LOG_DEBUG("[USER_MANAGER] Loaded user: " << user.username
+                    << ", ID=" << user.id);
 
                 users.push_back(user);
             }
 
-            std::cout << "[USER_MANAGER] Total users loaded: " << users.size() << std::endl;
-            std::cout << "[USER_MANAGER] Current last_user_id: " << last_user_id << std::endl;
+            rebuildIndexes();
+
+            LOG_INFO("[USER_MANAGER] Total users loaded: " << users.size());
+            LOG_INFO("[USER_MANAGER] Current last_user_id: " << last_user_id);
             return true;
         }
         catch (const simdjson::simdjson_error& e) {
-            std::cerr << "[USER_MANAGER] simdjson error loading users: " << e.what() << std::endl;
+            LOG_ERROR("[USER_MANAGER] simdjson error loading users: " << e.what());
             return false;
         }
         catch (const std::exception& e) {
-            std::cerr << "[USER_MANAGER] Error loading users: " << e.what() << std::endl;
+            LOG_ERROR("[USER_MANAGER] Error loading users: " << e.what());
             return false;
         }
     }
@@ -320,7 +353,12 @@ public:
    // In user_manager.h, in UserManager class
     bool saveUsers() {
         std::lock_guard<std::mutex> lock(mutex);
+        return saveUsersLocked();
+    }
 
+private:
+    // Writes the users list to disk, caller must hold mutex
+    bool saveUsersLocked() {
         try {
             // Generate JSON string using generateJsonString() method
             std::string json_str = generateJsonString();
@@ -328,7 +366,7 @@ public:
             // Write to file with error handling
             std::ofstream file(database_file);
             if (!file.is_open()) {
-                std::cerr << "[USER_MANAGER] Error: Could not open file for writing: " << database_file << std::endl;
+                LOG_ERROR("[USER_MANAGER] Error: Could not open file for writing: " << database_file);
                 return false;
             }
 
@@ -336,81 +374,74 @@ public:
 
             // Check if write operation was successful
             if (file.fail()) {
-                std::cerr << "[USER_MANAGER] Error: Failed to write to file: " << database_file << std::endl;
+                LOG_ERROR("[USER_MANAGER] Error: Failed to write to file: " << database_file);
                 file.close();
                 return false;
             }
 
             file.close();
-            std::cout << "[USER_MANAGER] Successfully saved " << users.size() << " users and last_user_id=" << last_user_id << " to file" << std::endl;
+            LOG_INFO("[USER_MANAGER] Successfully saved " << users.size() << " users and last_user_id=" << last_user_id << " to file");
             return true;
         }
         catch (const std::exception& e) {
-            std::cerr << "[USER_MANAGER] Error saving users: " << e.what() << std::endl;
+            LOG_ERROR("[USER_MANAGER] Error saving users: " << e.what());
             return false;
         }
     }
 
+public:
     // Modified registerUser method in UserManager class
     // To be added to user_manager.h, in UserManager class
 
  // In user_manager.h, in UserManager class
     bool registerUser(const User& user) {
-        //std::lock_guard<std::mutex> lock(mutex);
+        std::lock_guard<std::mutex> lock(mutex);
 
         // Check if user with same username already exists
-        for (const auto& existing_user : users) {
-            if (existing_user.username == user.username) {
-                std::cout << "[USER_MANAGER] Error: User with name " << user.username << " already exists!" << std::endl;
-                return false; // User already exists
-            }
+        if (findUserByName(user.username)) {
+            LOG_WARN("[USER_MANAGER] Error: User with name " << user.username << " already exists!");
+            return false; // User already exists
         }
 
-        // Create new user for registration
+        // Create new user for registration; admin rights are never granted by registering
         User new_user = user;
+        new_user.is_admin = false;
 
         // Increment last_user_id and assign it to new user
         last_user_id++;
         new_user.id = last_user_id;
 
-        std::cout << "[USER_MANAGER] Registering new user: " << new_user.username
-            << " with ID=" << new_user.id << std::endl;
+        LOG_INFO("[USER_MANAGER] Registering new user: " << new_user.username
+            << " with ID=" << new_user.id);
 
-        // Add user to the list
+        // Add user to the list and indexes
         users.push_back(new_user);
+        usersByName[new_user.username] = users.size() - 1;
+        usersByID[new_user.id] = users.size() - 1;
 
         // Save users list to file
-        bool saved = saveUsers();
+        bool saved = saveUsersLocked();
         if (!saved) {
-            std::cerr << "[USER_MANAGER] Failed to save users after registration!" << std::endl;
+            LOG_ERROR("[USER_MANAGER] Failed to save users after registration!");
         }
         return saved;
     }
     
     // Authenticate user with username and password
     bool authenticateUser(const std::string& username, const std::string& password) {
-        loadUsers();
-
-        for (const auto& user : users) {
-            if (user.username == username) {
-                if (user.password_hash == hashPassword(password)) {
-                    return true;
-                }
-                break;
-            }
-        }
+        std::lock_guard<std::mutex> lock(mutex);
 
-        return false;
+        const User* user = findUserByName(username);
+        return user && user->password_hash == hashPassword(password);
     }
 
     // Get username by client ID for online users
     std::string getUsernameByClientId(uint32_t clientId) {
         std::lock_guard<std::mutex> lock(mutex);
 
-        for (const auto& user : users) {
-            if (user.is_online && user.client_id == clientId) {
-                return user.username;
-            }
+        auto it = usersByClientID.find(clientId);
+        if (it != usersByClientID.end()) {
+            return users[it->second].username;
         }
 
         return ""; // User not found
@@ -422,11 +453,10 @@ std::string UserManager::getUsernameByID(uint32_t userID) {
     std::lock_guard<std::mutex> lock(mutex);
 
     try {
-        // Search for user in users list by ID
-        for (const auto& user : users) {
-            if (user.id == userID) {
-                return user.username;
-            }
+        // Look up user in the ID index
+        auto it = usersByID.find(userID);
+        if (it != usersByID.end()) {
+            return users[it->second].username;
         }
 
         // Return empty string if not found
@@ -434,7 +464,7 @@ std::string UserManager::getUsernameByID(uint32_t userID) {
 
     }
     catch (const std::exception& e) {
-        std::cerr << "[USER_MANAGER] Error in getUsernameByID: " << e.what() << std::endl;
+        LOG_ERROR("[USER_MANAGER] Error in getUsernameByID: " << e.what());
         return "";
     }
 }
\ No newline at end of file
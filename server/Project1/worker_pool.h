@@ -0,0 +1,96 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "net_mpscQueue.h"
+#include "logger.h"
+
+// Fixed pool of worker threads, each draining its own shard queue
+// Tasks submitted to the same shard run one at a time in submission order
+class WorkerPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // nWorkers = 0 uses one worker per hardware core
+    explicit WorkerPool(size_t nWorkers = 0)
+    {
+        if (nWorkers == 0)
+            nWorkers = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+        for (size_t i = 0; i < nWorkers; i++)
+            shards.push_back(std::make_unique<Shard>());
+
+        for (auto& shard : shards)
+        {
+            Shard* s = shard.get();
+            s->thread = std::thread([s]() { run(*s); });
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Finishes the tasks already queued on every shard, then joins the workers
+    ~WorkerPool()
+    {
+        for (auto& shard : shards)
+            shard->tasks.push_back(Task());
+
+        for (auto& shard : shards)
+        {
+            if (shard->thread.joinable())
+                shard->thread.join();
+        }
+    }
+
+    // Queues a task on the given shard (taken modulo the shard count)
+    void submit(size_t shardIndex, Task task)
+    {
+        shards[shardIndex % shards.size()]->tasks.push_back(std::move(task));
+    }
+
+    // Number of shards (one worker thread each)
+    size_t size() const
+    {
+        return shards.size();
+    }
+
+private:
+    struct Shard
+    {
+        olc::net::mpscQueue<Task> tasks;
+        std::thread thread;
+    };
+
+    // Worker loop: an empty task is the stop signal
+    static void run(Shard& shard)
+    {
+        Task task;
+        while (true)
+        {
+            shard.tasks.wait();
+            while (shard.tasks.try_pop(task))
+            {
+                if (!task)
+                    return;
+
+                try {
+                    task();
+                }
+                catch (const std::exception& e) {
+                    LOG_ERROR("[WORKER] Task failed: " << e.what());
+                }
+
+                task = nullptr;
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Shard>> shards;
+};
+
+#endif // WORKER_POOL_H
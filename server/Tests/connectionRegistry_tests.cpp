@@ -0,0 +1,139 @@
+// Slot reuse and generational IDs of olc::net::connectionRegistry
+
+#include "test.h"
+#include "../Project1/net_connectionRegistry.h"
+
+// The registry only stores and compares connection pointers, so a stand-in connection type will do
+enum class registryTestTag : uint32_t {};
+
+namespace olc
+{
+    namespace net
+    {
+        template<>
+        class connection<registryTestTag>
+        {
+        public:
+            explicit connection(int tag) : tag(tag) {}
+            int tag;
+        };
+    }
+}
+
+namespace
+{
+    using registry = olc::net::connectionRegistry<registryTestTag>;
+    using conn = olc::net::connection<registryTestTag>;
+
+    uint32_t slotOf(uint32_t id)
+    {
+        return id & (registry::MAX_SLOTS - 1);
+    }
+}
+
+TEST(registryHoldsHundredThousandConnections)
+{
+    CHECK(registry::MAX_SLOTS >= 100000u);
+    CHECK(uint64_t(registry::MAX_GENERATION) << registry::SLOT_BITS <= UINT32_MAX);
+}
+
+TEST(registryFindsInsertedConnections)
+{
+    registry connections;
+    auto first = std::make_shared<conn>(1);
+    auto second = std::make_shared<conn>(2);
+
+    uint32_t firstID = connections.insert(first);
+    uint32_t secondID = connections.insert(second);
+    CHECK(firstID != 0 && secondID != 0 && firstID != secondID);
+    CHECK_EQ(connections.size(), 2u);
+    CHECK(connections.find(firstID) == first);
+    CHECK(connections.find(secondID) == second);
+    CHECK(connections.find(0) == nullptr);
+    CHECK(connections.find(secondID + 1) == nullptr);
+
+    int visited = 0;
+    connections.forEach([&visited](const std::shared_ptr<conn>& c) { visited += c->tag; });
+    CHECK_EQ(visited, 3);
+}
+
+TEST(registryStaleIDNeverResolves)
+{
+    registry connections;
+    auto old = std::make_shared<conn>(1);
+    uint32_t oldID = connections.insert(old);
+
+    CHECK(connections.remove(oldID));
+    CHECK(!connections.remove(oldID));
+    CHECK(connections.find(oldID) == nullptr);
+    CHECK_EQ(connections.size(), 0u);
+
+    // The slot is reused under a new generation
+    auto reused = std::make_shared<conn>(2);
+    uint32_t reusedID = connections.insert(reused);
+    CHECK_EQ(slotOf(reusedID), slotOf(oldID));
+    CHECK(reusedID != oldID);
+    CHECK(connections.find(oldID) == nullptr);
+    CHECK(connections.find(reusedID) == reused);
+    CHECK(!connections.remove(oldID));
+    CHECK(connections.find(reusedID) == reused);
+}
+
+TEST(registryRemoveChecksConnection)
+{
+    registry connections;
+    auto current = std::make_shared<conn>(1);
+    auto other = std::make_shared<conn>(2);
+    uint32_t id = connections.insert(current);
+
+    CHECK(!connections.remove(id, other));
+    CHECK(connections.find(id) == current);
+    CHECK(connections.remove(id, current));
+    CHECK(connections.find(id) == nullptr);
+}
+
+TEST(registryReusesLongestFreeSlot)
+{
+    registry connections;
+    std::vector<uint32_t> ids;
+    for (int i = 0; i < 4; i++)
+        ids.push_back(connections.insert(std::make_shared<conn>(i)));
+
+    connections.remove(ids[2]);
+    connections.remove(ids[0]);
+    CHECK_EQ(slotOf(connections.insert(std::make_shared<conn>(5))), slotOf(ids[2]));
+    CHECK_EQ(slotOf(connections.insert(std::make_shared<conn>(6))), slotOf(ids[0]));
+}
+
+TEST(registryGenerationsWrapWithoutZeroID)
+{
+    registry connections;
+    auto c = std::make_shared<conn>(1);
+    uint32_t firstID = connections.insert(c);
+    uint32_t id = firstID;
+
+    // Cycle one slot through every generation; IDs stay non-zero and eventually repeat
+    bool sawZero = false;
+    bool wrapped = false;
+    for (uint32_t cycle = 0; cycle < registry::MAX_GENERATION; cycle++)
+    {
+        connections.remove(id);
+        id = connections.insert(c);
+        sawZero = sawZero || id == 0;
+        wrapped = wrapped || id == firstID;
+    }
+    CHECK(!sawZero);
+    CHECK(wrapped);
+    CHECK_EQ(slotOf(id), slotOf(firstID));
+}
+
+TEST(registryRefusesWhenFull)
+{
+    registry connections;
+    auto c = std::make_shared<conn>(1);
+    for (uint32_t i = 0; i < registry::MAX_SLOTS; i++)
+        connections.insert(c);
+
+    CHECK_EQ(connections.size(), size_t(registry::MAX_SLOTS));
+    CHECK_EQ(connections.insert(c), 0u);
+}
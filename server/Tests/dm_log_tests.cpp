@@ -0,0 +1,295 @@
+// Record format, crash recovery, index rebuild, legacy import and paging of DirectMessageLog
+
+#include "test.h"
+#include <fstream>
+#include <iterator>
+#include "../Project1/dm_log.h"
+
+namespace
+{
+    const char* const LOG_PATH = "chat_alice_bob.log";
+    const char* const INDEX_PATH = "chat_alice_bob.idx";
+
+    ChatRecord makeRecord(uint32_t i)
+    {
+        ChatRecord record;
+        record.messageID = 1700000000000ull + i;
+        record.senderUserID = 1;
+        record.recipientUserID = 2;
+        record.senderUsername = "alice";
+        record.recipientUsername = "bob";
+        record.timestamp = "2024-01-01 12:00:00";
+        record.messageText = "message " + std::to_string(i);
+        return record;
+    }
+
+    // Appends records first .. first + count - 1 and waits until they are in the file
+    void writeRecords(uint32_t first, uint32_t count)
+    {
+        PersistenceStage stage(PersistenceStage::FsyncPolicy::None);
+        DirectMessageLog log;
+        log.setPersistence(&stage);
+        for (uint32_t i = first; i < first + count; i++)
+            log.append("alice", "bob", makeRecord(i));
+        stage.flush();
+    }
+
+    // Opens the log afresh, as after a restart
+    uint32_t reopenedCount()
+    {
+        DirectMessageLog log;
+        return log.messageCount("bob", "alice");
+    }
+
+    std::vector<ChatRecord> readAll()
+    {
+        DirectMessageLog log;
+        return log.readPage(log.locatePage("alice", "bob", UINT32_MAX, UINT32_MAX)).records;
+    }
+}
+
+TEST(dmLogFileNameIgnoresArgumentOrder)
+{
+    CHECK_EQ(DirectMessageLog::fileName("bob", "alice"), std::string(LOG_PATH));
+    CHECK_EQ(DirectMessageLog::fileName("alice", "bob"), std::string(LOG_PATH));
+}
+
+TEST(dmLogRecordsSurviveReopen)
+{
+    tests::scratchDirectory dir("dm_log_reopen");
+    writeRecords(0, 100);
+    CHECK_EQ(reopenedCount(), 100u);
+
+    // One checkpoint per INDEX_INTERVAL records
+    CHECK_EQ(std::filesystem::file_size(INDEX_PATH), 2 * sizeof(uint64_t));
+
+    std::vector<ChatRecord> records = readAll();
+    CHECK_EQ(records.size(), 100u);
+    CHECK_EQ(records.back().messageText, "message 99");
+    CHECK_EQ(records.back().messageID, 1700000000099ull);
+    CHECK_EQ(records.back().senderUsername, "alice");
+}
+
+TEST(dmLogTornTailIsTruncated)
+{
+    tests::scratchDirectory dir("dm_log_torn");
+    writeRecords(0, 10);
+    uint64_t nineRecords = 0;
+    {
+        // Size of the log before the last record was appended
+        tests::scratchDirectory probe("dm_log_torn_probe");
+        writeRecords(0, 9);
+        nineRecords = std::filesystem::file_size(LOG_PATH);
+    }
+    uint64_t fullSize = std::filesystem::file_size(LOG_PATH);
+
+    // A crash in the middle of the last record
+    std::filesystem::resize_file(LOG_PATH, fullSize - 5);
+    CHECK_EQ(reopenedCount(), 9u);
+    CHECK_EQ(std::filesystem::file_size(LOG_PATH), nineRecords);
+
+    // Later appends follow the last intact record and stay readable
+    writeRecords(9, 1);
+    CHECK_EQ(reopenedCount(), 10u);
+    CHECK_EQ(std::filesystem::file_size(LOG_PATH), fullSize);
+    std::vector<ChatRecord> records = readAll();
+    CHECK_EQ(records.size(), 10u);
+    CHECK_EQ(records.back().messageText, "message 9");
+}
+
+TEST(dmLogCorruptedRecordEndsLog)
+{
+    tests::scratchDirectory dir("dm_log_crc");
+    writeRecords(0, 10);
+    uint64_t fullSize = std::filesystem::file_size(LOG_PATH);
+
+    // Flip one byte in the payload of the last record; its CRC no longer matches
+    {
+        std::fstream file(LOG_PATH, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekg(static_cast<std::streamoff>(fullSize - 1));
+        char byte = 0;
+        file.read(&byte, 1);
+        byte ^= 0x20;
+        file.seekp(static_cast<std::streamoff>(fullSize - 1));
+        file.write(&byte, 1);
+    }
+
+    CHECK_EQ(reopenedCount(), 9u);
+    CHECK(std::filesystem::file_size(LOG_PATH) < fullSize);
+}
+
+TEST(dmLogMissingIndexIsRebuilt)
+{
+    tests::scratchDirectory dir("dm_log_index");
+    writeRecords(0, 130);
+    std::string original;
+    {
+        std::ifstream index(INDEX_PATH, std::ios::binary);
+        original.assign(std::istreambuf_iterator<char>(index), std::istreambuf_iterator<char>());
+    }
+    CHECK_EQ(original.size(), 3 * sizeof(uint64_t));
+
+    std::filesystem::remove(INDEX_PATH);
+    CHECK_EQ(reopenedCount(), 130u);
+
+    std::string rebuilt;
+    {
+        std::ifstream index(INDEX_PATH, std::ios::binary);
+        rebuilt.assign(std::istreambuf_iterator<char>(index), std::istreambuf_iterator<char>());
+    }
+    CHECK(rebuilt == original);
+}
+
+TEST(dmLogDamagedIndexIsRebuilt)
+{
+    tests::scratchDirectory dir("dm_log_bad_index");
+    writeRecords(0, 130);
+
+    // Checkpoints pointing past the end of the log are dropped and the rest rescanned
+    {
+        std::ofstream index(INDEX_PATH, std::ios::binary | std::ios::app);
+        uint64_t bogus = 1ull << 40;
+        index.write(reinterpret_cast<const char*>(&bogus), sizeof(bogus));
+    }
+    CHECK_EQ(reopenedCount(), 130u);
+    CHECK_EQ(std::filesystem::file_size(INDEX_PATH), 3 * sizeof(uint64_t));
+    CHECK_EQ(readAll().size(), 130u);
+}
+
+TEST(dmLogImportsLegacyJson)
+{
+    tests::scratchDirectory dir("dm_log_legacy");
+    {
+        std::ofstream json("chat_alice_bob.json");
+        json << R"({"messages":[)"
+            << R"({"message_id":1700000000001,"sender_user_id":1,"recipient_user_id":2,"sender_username":"alice",)"
+            << R"("recipient_username":"bob","timestamp":"2024-01-01 12:00:00","message_text":"hello"},)"
+            << R"({"message_id":1700000000002,"sender_user_id":2,"recipient_user_id":1,"sender_username":"bob",)"
+            << R"("recipient_username":"alice","timestamp":"2024-01-01 12:00:01","message_text":"hi"}]})";
+    }
+
+    CHECK_EQ(reopenedCount(), 2u);
+    CHECK(std::filesystem::exists(LOG_PATH));
+
+    std::vector<ChatRecord> records = readAll();
+    CHECK_EQ(records.size(), 2u);
+    if (records.size() == 2)
+    {
+        CHECK_EQ(records[0].messageText, "hello");
+        CHECK_EQ(records[1].senderUsername, "bob");
+        CHECK_EQ(records[1].senderUserID, 2u);
+        CHECK_EQ(records[1].messageID, 1700000000002ull);
+    }
+
+    // New messages go after the imported ones
+    writeRecords(0, 1);
+    CHECK_EQ(reopenedCount(), 3u);
+}
+
+TEST(dmLogKeepsUnreadableLegacyJson)
+{
+    tests::scratchDirectory dir("dm_log_legacy_bad");
+    {
+        std::ofstream json("chat_alice_bob.json");
+        json << R"({"messages":[{"message_text":"cut off)";
+    }
+
+    CHECK_EQ(reopenedCount(), 0u);
+    CHECK(!std::filesystem::exists(LOG_PATH));
+    CHECK(std::filesystem::exists("chat_alice_bob.json"));
+}
+
+TEST(dmLogNewestPageComesFirst)
+{
+    tests::scratchDirectory dir("dm_log_page_newest");
+    writeRecords(0, 200);
+
+    DirectMessageLog log;
+    DirectMessageLog::PageLocation location = log.locatePage("alice", "bob", UINT32_MAX, 50);
+    CHECK_EQ(location.startSeq, 150u);
+    CHECK_EQ(location.endSeq, 200u);
+    CHECK_EQ(location.total, 200u);
+
+    // The read starts at the checkpoint at or before the page instead of the start of the file
+    CHECK_EQ(location.offsetSeq, 2 * DirectMessageLog::INDEX_INTERVAL);
+    CHECK(location.offset > 0);
+
+    ChatPage page = log.readPage(location);
+    CHECK_EQ(page.firstSeq, 150u);
+    CHECK_EQ(page.total, 200u);
+    CHECK_EQ(page.records.size(), 50u);
+    CHECK_EQ(page.records.front().messageText, "message 150");
+    CHECK_EQ(page.records.back().messageText, "message 199");
+}
+
+TEST(dmLogPagesWalkBackToOldest)
+{
+    tests::scratchDirectory dir("dm_log_page_walk");
+    writeRecords(0, 200);
+
+    DirectMessageLog log;
+    std::vector<std::string> texts;
+    uint32_t beforeSeq = UINT32_MAX;
+    int nPages = 0;
+    for (;;)
+    {
+        ChatPage page = log.readPage(log.locatePage("alice", "bob", beforeSeq, 30));
+        if (page.records.empty())
+            break;
+        for (auto it = page.records.rbegin(); it != page.records.rend(); ++it)
+            texts.push_back(it->messageText);
+        beforeSeq = page.firstSeq;
+        nPages++;
+    }
+
+    // Seven pages of 30 cover 200 messages, the last one holding the oldest 20, none repeated or skipped
+    CHECK_EQ(nPages, 7);
+    CHECK_EQ(texts.size(), 200u);
+    bool ordered = true;
+    for (size_t i = 0; i < texts.size(); i++)
+        ordered = ordered && texts[i] == "message " + std::to_string(199 - i);
+    CHECK(ordered);
+}
+
+TEST(dmLogEmptyPages)
+{
+    tests::scratchDirectory dir("dm_log_page_empty");
+    DirectMessageLog log;
+    ChatPage none = log.readPage(log.locatePage("alice", "bob", UINT32_MAX, 50));
+    CHECK(none.records.empty());
+    CHECK_EQ(none.total, 0u);
+
+    writeRecords(0, 10);
+    DirectMessageLog reopened;
+    ChatPage zeroLimit = reopened.readPage(reopened.locatePage("alice", "bob", UINT32_MAX, 0));
+    CHECK(zeroLimit.records.empty());
+    CHECK_EQ(zeroLimit.total, 10u);
+    ChatPage beforeOldest = reopened.readPage(reopened.locatePage("alice", "bob", 0, 50));
+    CHECK(beforeOldest.records.empty());
+}
+
+TEST(dmLogReadPageWritesQueuedAppends)
+{
+    tests::scratchDirectory dir("dm_log_page_queued");
+    PersistenceStage stage(PersistenceStage::FsyncPolicy::None);
+    DirectMessageLog log;
+    log.setPersistence(&stage);
+    for (uint32_t i = 0; i < 5; i++)
+        log.append("alice", "bob", makeRecord(i));
+
+    // No flush here: appends still queued for the writer thread must be read anyway
+    DirectMessageLog::PageLocation location = log.locatePage("alice", "bob", UINT32_MAX, 50);
+    for (uint32_t i = 5; i < 10; i++)
+        log.append("alice", "bob", makeRecord(i));
+
+    // The page stays what it was when it was located
+    ChatPage page = log.readPage(location);
+    CHECK_EQ(page.total, 5u);
+    CHECK_EQ(page.records.size(), 5u);
+    CHECK_EQ(page.records.back().messageText, "message 4");
+
+    ChatPage newest = log.readPage(log.locatePage("alice", "bob", UINT32_MAX, 3));
+    CHECK_EQ(newest.firstSeq, 7u);
+    CHECK_EQ(newest.records.size(), 3u);
+    CHECK_EQ(newest.records.back().messageText, "message 9");
+}
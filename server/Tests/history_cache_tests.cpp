@@ -0,0 +1,143 @@
+// Windows, LRU order and memory budget of HistoryCache
+
+#include "test.h"
+#include "../Project1/history_cache.h"
+
+namespace
+{
+    // Bytes the cache charges for one message of the given size
+    const size_t MESSAGE_SIZE = 100;
+    const size_t MESSAGE_COST = sizeof(std::string) + MESSAGE_SIZE;
+
+    std::string messageText(uint32_t seq)
+    {
+        std::string text = "#" + std::to_string(seq);
+        text.resize(MESSAGE_SIZE, '.');
+        return text;
+    }
+
+    // Messages firstSeq .. firstSeq + count - 1
+    std::vector<std::string> messages(uint32_t firstSeq, uint32_t count)
+    {
+        std::vector<std::string> result;
+        for (uint32_t seq = firstSeq; seq < firstSeq + count; seq++)
+            result.push_back(messageText(seq));
+        return result;
+    }
+
+    bool cached(HistoryCache& cache, const std::string& conversation)
+    {
+        HistoryPage page;
+        return cache.find(conversation, UINT32_MAX, 1, page);
+    }
+}
+
+TEST(historyCacheServesNewestWindow)
+{
+    HistoryCache cache;
+    cache.addPage("a", 10, 20, messages(10, 10));
+
+    HistoryPage page;
+    CHECK(cache.find("a", UINT32_MAX, 4, page));
+    CHECK_EQ(page.firstSeq, 16u);
+    CHECK_EQ(page.count, 4u);
+    CHECK_EQ(page.total, 20u);
+    CHECK(page.entries == messageText(16) + messageText(17) + messageText(18) + messageText(19));
+
+    // Pages reaching before the window are left to the log
+    CHECK(cache.find("a", 14, 4, page));
+    CHECK_EQ(page.firstSeq, 10u);
+    CHECK(!cache.find("a", 13, 4, page));
+    CHECK(!cache.find("b", UINT32_MAX, 4, page));
+}
+
+TEST(historyCacheOnlyStartsWindowAtNewestMessage)
+{
+    HistoryCache cache;
+    cache.addPage("a", 0, 20, messages(0, 10));
+    CHECK(!cached(cache, "a"));
+    CHECK_EQ(cache.bytes(), 0u);
+}
+
+TEST(historyCachePrependsOlderPage)
+{
+    HistoryCache cache;
+    cache.addPage("a", 10, 20, messages(10, 10));
+    cache.addPage("a", 5, 20, messages(5, 10));
+
+    HistoryPage page;
+    CHECK(cache.find("a", 10, 5, page));
+    CHECK_EQ(page.firstSeq, 5u);
+    CHECK(page.entries.substr(0, MESSAGE_SIZE) == messageText(5));
+    CHECK_EQ(cache.bytes(), 15 * MESSAGE_COST);
+}
+
+TEST(historyCacheAppendExtendsWindow)
+{
+    HistoryCache cache;
+    cache.addPage("a", 0, 3, messages(0, 3));
+    cache.append("a", messageText(3));
+
+    HistoryPage page;
+    CHECK(cache.find("a", UINT32_MAX, 1, page));
+    CHECK_EQ(page.firstSeq, 3u);
+    CHECK_EQ(page.total, 4u);
+    CHECK(page.entries == messageText(3));
+
+    // Conversations not cached stay that way
+    cache.append("b", messageText(0));
+    CHECK(!cached(cache, "b"));
+    CHECK_EQ(cache.bytes(), 4 * MESSAGE_COST);
+}
+
+TEST(historyCacheTrimsLongConversations)
+{
+    HistoryCache cache(16 * 1024 * 1024, 10);
+    cache.addPage("a", 0, 15, messages(0, 15));
+    CHECK_EQ(cache.bytes(), 10 * MESSAGE_COST);
+
+    HistoryPage page;
+    CHECK(cache.find("a", UINT32_MAX, 10, page));
+    CHECK_EQ(page.firstSeq, 5u);
+    CHECK(!cache.find("a", 5, 1, page));
+
+    cache.append("a", messageText(15));
+    CHECK_EQ(cache.bytes(), 10 * MESSAGE_COST);
+    CHECK(cache.find("a", UINT32_MAX, 10, page));
+    CHECK_EQ(page.firstSeq, 6u);
+}
+
+TEST(historyCacheEvictsLeastRecentlyUsedWithinBudget)
+{
+    // Room for three conversations of ten messages
+    const size_t budget = 3 * 10 * MESSAGE_COST;
+    HistoryCache cache(budget);
+    cache.addPage("a", 0, 10, messages(0, 10));
+    cache.addPage("b", 0, 10, messages(0, 10));
+    cache.addPage("c", 0, 10, messages(0, 10));
+    CHECK_EQ(cache.bytes(), budget);
+
+    // Reading a makes b the least recently used
+    CHECK(cached(cache, "a"));
+    cache.addPage("d", 0, 10, messages(0, 10));
+    CHECK(cache.bytes() <= budget);
+    CHECK(!cached(cache, "b"));
+    CHECK(cached(cache, "a"));
+    CHECK(cached(cache, "c"));
+    CHECK(cached(cache, "d"));
+
+    // Growing one conversation pushes out the least recently used other one
+    cache.append("d", messageText(10));
+    CHECK(cache.bytes() <= budget);
+    CHECK(!cached(cache, "a"));
+    CHECK(cached(cache, "c"));
+    CHECK(cached(cache, "d"));
+}
+
+TEST(historyCacheDropsConversationLargerThanBudget)
+{
+    HistoryCache cache(5 * MESSAGE_COST);
+    cache.addPage("a", 0, 10, messages(0, 10));
+    CHECK(!cached(cache, "a"));
+    CHECK_EQ(cache.bytes(), 0u);
+}
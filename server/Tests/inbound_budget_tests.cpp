@@ -0,0 +1,84 @@
+// Receive budget accounting of incoming messages (inbound_budget and budget_charge)
+
+#include "test.h"
+#include "../Project1/net_connection.h"
+
+namespace
+{
+    enum class budgetTestMsg : uint32_t { Data };
+    using message = olc::net::message<budgetTestMsg>;
+}
+
+TEST(budgetReserveStopsAtCapacity)
+{
+    olc::net::inbound_budget budget;
+    budget.capacity = 100;
+    CHECK(budget.reserve(60));
+    CHECK(!budget.reserve(50));
+    CHECK(budget.canAdmit(40));
+    CHECK(budget.reserve(40));
+    CHECK(budget.exhausted());
+    budget.release(100);
+    CHECK_EQ(budget.used.load(), 0u);
+}
+
+TEST(budgetChargeReleasedWithMessage)
+{
+    olc::net::inbound_budget budget;
+    budget.capacity = 100;
+    {
+        message msg;
+        msg.charge = budget.charge(150);    // Already received, so it may pass the capacity
+        CHECK_EQ(budget.used.load(), 150u);
+        CHECK(budget.exhausted());
+    }
+    CHECK_EQ(budget.used.load(), 0u);
+}
+
+TEST(budgetChargeFollowsMovedMessage)
+{
+    // What onMessage does: the body moves into a worker task and is released once that task is gone
+    olc::net::inbound_budget budget;
+    message msg;
+    msg.charge = budget.charge(64);
+
+    std::function<void()> task = [moved = std::move(msg)]() {};
+    msg = message();
+    CHECK_EQ(budget.used.load(), 64u);
+
+    task();
+    CHECK_EQ(budget.used.load(), 64u);
+    task = nullptr;
+    CHECK_EQ(budget.used.load(), 0u);
+}
+
+TEST(budgetChargeNotDuplicatedByCopies)
+{
+    olc::net::inbound_budget budget;
+    {
+        message original;
+        original.charge = budget.charge(10);
+        {
+            message copy = original;
+            message assigned;
+            assigned = original;
+        }
+        CHECK_EQ(budget.used.load(), 10u);
+
+        // Assigning over a charged message gives its bytes back
+        original = message();
+        CHECK_EQ(budget.used.load(), 0u);
+    }
+    CHECK_EQ(budget.used.load(), 0u);
+}
+
+TEST(budgetChargeEarlyRelease)
+{
+    olc::net::inbound_budget budget;
+    message msg;
+    msg.charge = budget.charge(8);
+    msg.charge.release();
+    CHECK_EQ(budget.used.load(), 0u);
+    msg.charge.release();
+    CHECK_EQ(budget.used.load(), 0u);
+}
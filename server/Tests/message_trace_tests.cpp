@@ -0,0 +1,133 @@
+// Stage arithmetic of olc::net::message_trace
+
+#include "test.h"
+#include "../Project1/net_messageTrace.h"
+
+namespace
+{
+    using olc::net::message_trace;
+    using HistogramId = Metrics::HistogramId;
+    using us = std::chrono::microseconds;
+
+    // What a completed trace added to each stage histogram, as count and sum
+    struct stageDelta
+    {
+        uint64_t count;
+        uint64_t sum;
+    };
+
+    class traceRecorder
+    {
+    public:
+        traceRecorder()
+            : m_before(Metrics::instance().snapshot())
+        {
+        }
+
+        stageDelta operator()(HistogramId id) const
+        {
+            Metrics::Snapshot after = Metrics::instance().snapshot();
+            return { after.histogram(id).count - m_before.histogram(id).count,
+                after.histogram(id).sum - m_before.histogram(id).sum };
+        }
+
+        uint64_t traced() const
+        {
+            return Metrics::instance().snapshot().counter(Metrics::CounterId::TracedMessages) -
+                m_before.counter(Metrics::CounterId::TracedMessages);
+        }
+
+    private:
+        Metrics::Snapshot m_before;
+    };
+
+    bool recorded(const stageDelta& delta, uint64_t micros)
+    {
+        return delta.count == 1 && delta.sum == micros;
+    }
+}
+
+TEST(traceRecordsEveryStage)
+{
+    traceRecorder recorder;
+    auto start = message_trace::clock::now();
+    {
+        message_trace trace;
+        trace.headerRead = start;
+        trace.bodyRead = start + us(10);
+        trace.enqueued = start + us(30);
+        trace.dispatchStart = start + us(100);
+        trace.dispatchEnd = start + us(150);
+        trace.handlerStart = start + us(140);   // The worker started before onMessage returned
+        trace.handlerEnd = start + us(400);
+        trace.writeCompleted(start + us(1000));
+        trace.writeCompleted(start + us(900));  // An earlier write does not move the end back
+    }
+
+    CHECK_EQ(recorder.traced(), 1u);
+    CHECK(recorded(recorder(HistogramId::TraceReceive), 10));
+    CHECK(recorded(recorder(HistogramId::TraceEnqueue), 20));
+    CHECK(recorded(recorder(HistogramId::TraceIncomingQueue), 70));
+    CHECK(recorded(recorder(HistogramId::TraceDispatch), 50));
+    CHECK(recorded(recorder(HistogramId::TraceWorkerQueue), 0));
+    CHECK(recorded(recorder(HistogramId::TraceHandler), 260));
+    CHECK(recorded(recorder(HistogramId::TraceWrite), 600));
+    CHECK(recorded(recorder(HistogramId::TraceTotal), 1000));
+}
+
+TEST(traceSkipsStagesNeverReached)
+{
+    // An unhandled message: queued and dispatched, but no handler ran and nothing was written
+    traceRecorder recorder;
+    auto start = message_trace::clock::now();
+    {
+        message_trace trace;
+        trace.headerRead = start;
+        trace.bodyRead = start + us(5);
+        trace.enqueued = start + us(8);
+        trace.dispatchStart = start + us(20);
+        trace.dispatchEnd = start + us(25);
+    }
+
+    CHECK(recorded(recorder(HistogramId::TraceReceive), 5));
+    CHECK(recorded(recorder(HistogramId::TraceEnqueue), 3));
+    CHECK(recorded(recorder(HistogramId::TraceIncomingQueue), 12));
+    CHECK(recorded(recorder(HistogramId::TraceDispatch), 5));
+    CHECK_EQ(recorder(HistogramId::TraceWorkerQueue).count, 0u);
+    CHECK_EQ(recorder(HistogramId::TraceHandler).count, 0u);
+    CHECK_EQ(recorder(HistogramId::TraceWrite).count, 0u);
+    CHECK(recorded(recorder(HistogramId::TraceTotal), 25));
+}
+
+TEST(traceCompletesWhenLastReferenceGoes)
+{
+    traceRecorder recorder;
+    olc::net::trace_ptr message = std::make_shared<message_trace>();
+    message->headerRead = message_trace::clock::now();
+    {
+        // The handler scope attributes frames to the trace while it runs, then drops the message's reference
+        olc::net::handler_trace_scope scope(message);
+        CHECK(olc::net::current_trace() == message);
+    }
+    CHECK(!message);
+    CHECK(!olc::net::current_trace());
+    CHECK_EQ(recorder.traced(), 1u);
+    CHECK_EQ(recorder(HistogramId::TraceHandler).count, 1u);
+}
+
+TEST(traceWaitsForQueuedFrames)
+{
+    traceRecorder recorder;
+    olc::net::trace_ptr message = std::make_shared<message_trace>();
+    olc::net::trace_ptr queuedFrame;
+    {
+        olc::net::handler_trace_scope scope(message);
+        queuedFrame = olc::net::current_trace();    // What a connection keeps for a frame sent meanwhile
+    }
+    CHECK_EQ(recorder.traced(), 0u);
+
+    queuedFrame->writeCompleted(message_trace::clock::now());
+    queuedFrame.reset();
+    CHECK_EQ(recorder.traced(), 1u);
+    CHECK_EQ(recorder(HistogramId::TraceWrite).count, 1u);
+}
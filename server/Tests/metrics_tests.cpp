@@ -0,0 +1,109 @@
+// Histogram bucketing and percentiles of Metrics
+
+#include "test.h"
+#include "../Project1/metrics.h"
+
+namespace
+{
+    using Histogram = Metrics::Histogram;
+
+    Metrics::HistogramSnapshot snapshotOf(const std::vector<uint64_t>& values)
+    {
+        Histogram histogram;
+        for (uint64_t value : values)
+            histogram.record(value);
+
+        Metrics::HistogramSnapshot snapshot;
+        snapshot.add(histogram);
+        return snapshot;
+    }
+}
+
+TEST(histogramSmallValuesHaveOwnBuckets)
+{
+    for (uint64_t value = 0; value < Histogram::SUB_BUCKETS; value++)
+    {
+        CHECK_EQ(Histogram::bucketOf(value), size_t(value));
+        CHECK_EQ(Histogram::bucketLimit(size_t(value)), value);
+    }
+}
+
+TEST(histogramBucketsAreContiguousAndOrdered)
+{
+    // Every value falls into the first bucket whose limit is not below it
+    uint64_t lowest = 0;
+    for (size_t bucket = 0; bucket + 1 < Histogram::BUCKETS; bucket++)
+    {
+        uint64_t limit = Histogram::bucketLimit(bucket);
+        CHECK(limit >= lowest);
+        CHECK_EQ(Histogram::bucketOf(lowest), bucket);
+        CHECK_EQ(Histogram::bucketOf(limit), bucket);
+        lowest = limit + 1;
+    }
+    CHECK_EQ(Histogram::bucketOf(UINT32_MAX), Histogram::BUCKETS - 1);
+    CHECK_EQ(Histogram::bucketLimit(Histogram::BUCKETS - 1), uint64_t(UINT32_MAX));
+}
+
+TEST(histogramBucketWidthWithinOneSixteenth)
+{
+    for (uint64_t value : { 16ull, 17ull, 100ull, 1000ull, 123456ull, 4000000000ull })
+    {
+        size_t bucket = Histogram::bucketOf(value);
+        uint64_t limit = Histogram::bucketLimit(bucket);
+        uint64_t low = bucket == 0 ? 0 : Histogram::bucketLimit(bucket - 1) + 1;
+        CHECK(low <= value && value <= limit);
+        CHECK((limit - low + 1) * Histogram::SUB_BUCKETS <= low + Histogram::SUB_BUCKETS);
+    }
+}
+
+TEST(histogramClampsLargeValues)
+{
+    Metrics::HistogramSnapshot snapshot = snapshotOf({ uint64_t(1) << 40 });
+    CHECK_EQ(snapshot.count, 1u);
+    CHECK_EQ(snapshot.max, uint64_t(UINT32_MAX));
+    CHECK_EQ(snapshot.buckets[Histogram::BUCKETS - 1], 1u);
+}
+
+TEST(histogramPercentiles)
+{
+    std::vector<uint64_t> values;
+    for (uint64_t value = 1; value <= 100; value++)
+        values.push_back(value);
+    Metrics::HistogramSnapshot snapshot = snapshotOf(values);
+
+    CHECK_EQ(snapshot.count, 100u);
+    CHECK_EQ(snapshot.sum, 5050u);
+    CHECK_EQ(snapshot.mean(), 50u);
+    CHECK_EQ(snapshot.max, 100u);
+
+    // The reported value is the upper bound of the bucket holding the rank, never above max
+    uint64_t p50 = snapshot.percentile(0.50);
+    CHECK_EQ(p50, Histogram::bucketLimit(Histogram::bucketOf(50)));
+    CHECK(p50 >= 50 && p50 < 54);
+    CHECK_EQ(snapshot.percentile(1.0), 100u);
+    CHECK_EQ(snapshot.percentile(0.0), 1u);
+}
+
+TEST(histogramEmptySnapshot)
+{
+    Metrics::HistogramSnapshot snapshot = snapshotOf({});
+    CHECK_EQ(snapshot.count, 0u);
+    CHECK_EQ(snapshot.percentile(0.99), 0u);
+    CHECK_EQ(snapshot.mean(), 0u);
+}
+
+TEST(histogramSnapshotSumsHistograms)
+{
+    Histogram first, second;
+    first.record(3);
+    second.record(3);
+    second.record(200);
+
+    Metrics::HistogramSnapshot snapshot;
+    snapshot.add(first);
+    snapshot.add(second);
+    CHECK_EQ(snapshot.count, 3u);
+    CHECK_EQ(snapshot.sum, 206u);
+    CHECK_EQ(snapshot.max, 200u);
+    CHECK_EQ(snapshot.buckets[3], 2u);
+}
@@ -0,0 +1,133 @@
+// Ordering, draining, depth and parking of olc::net::mpscQueue
+
+#include "test.h"
+#include "../Project1/net_mpscQueue.h"
+
+TEST(mpscQueueIsFifo)
+{
+    olc::net::mpscQueue<int> queue;
+    CHECK(queue.empty());
+
+    for (int i = 0; i < 5; i++)
+        CHECK_EQ(queue.push_back(i), size_t(i));
+    CHECK(!queue.empty());
+    CHECK_EQ(queue.size(), 5u);
+
+    int value = -1;
+    for (int i = 0; i < 5; i++)
+    {
+        CHECK(queue.try_pop(value));
+        CHECK_EQ(value, i);
+    }
+    CHECK(!queue.try_pop(value));
+    CHECK(queue.empty());
+    CHECK_EQ(queue.size(), 0u);
+}
+
+TEST(mpscQueueDrainHonoursLimit)
+{
+    olc::net::mpscQueue<std::string> queue;
+    for (int i = 0; i < 10; i++)
+        queue.push_back(std::to_string(i));
+
+    std::vector<std::string> batch;
+    CHECK_EQ(queue.drain(batch, 4), 4u);
+    CHECK_EQ(batch.size(), 4u);
+    CHECK_EQ(batch.front(), "0");
+    CHECK_EQ(queue.size(), 6u);
+
+    CHECK_EQ(queue.drain(batch), 6u);
+    CHECK_EQ(batch.back(), "9");
+    CHECK(queue.empty());
+}
+
+TEST(mpscQueueReusableAfterEmpty)
+{
+    // Popping the last element re-inserts the stub; the queue must keep working afterwards
+    olc::net::mpscQueue<int> queue;
+    int value = 0;
+    for (int round = 0; round < 3; round++)
+    {
+        queue.push_back(round);
+        CHECK(queue.try_pop(value));
+        CHECK_EQ(value, round);
+        CHECK(!queue.try_pop(value));
+    }
+}
+
+TEST(mpscQueueClearReleasesElements)
+{
+    auto element = std::make_shared<int>(7);
+    {
+        olc::net::mpscQueue<std::shared_ptr<int>> queue;
+        queue.push_back(element);
+        queue.push_back(element);
+        CHECK_EQ(element.use_count(), 3);
+        queue.clear();
+        CHECK_EQ(element.use_count(), 1);
+        queue.push_back(element);
+    }
+    CHECK_EQ(element.use_count(), 1);
+}
+
+TEST(mpscQueueManyProducersLoseNothing)
+{
+    const int nProducers = 4;
+    const int nPerProducer = 20000;
+    olc::net::mpscQueue<std::pair<int, int>> queue;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < nProducers; p++)
+    {
+        producers.emplace_back([&queue, p, nPerProducer]()
+            {
+                for (int i = 0; i < nPerProducer; i++)
+                    queue.push_back({ p, i });
+            });
+    }
+
+    // Each producer's elements arrive in the order it pushed them
+    std::vector<int> next(nProducers, 0);
+    int received = 0;
+    bool ordered = true;
+    std::pair<int, int> item;
+    while (received < nProducers * nPerProducer)
+    {
+        queue.wait();
+        while (queue.try_pop(item))
+        {
+            ordered = ordered && item.second == next[item.first];
+            next[item.first] = item.second + 1;
+            received++;
+        }
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+
+    CHECK(ordered);
+    CHECK_EQ(received, nProducers * nPerProducer);
+    CHECK(queue.empty());
+    CHECK_EQ(queue.size(), 0u);
+}
+
+TEST(mpscQueueWaitWakesParkedConsumer)
+{
+    olc::net::mpscQueue<int> queue;
+    CHECK(!queue.wait_for(std::chrono::milliseconds(10)));
+
+    std::thread producer([&queue]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            queue.push_back(42);
+        });
+
+    // Parks until the producer pushes; a missed wakeup would hang here until the timeout
+    bool woken = queue.wait_for(std::chrono::seconds(10));
+    producer.join();
+
+    int value = 0;
+    CHECK(woken);
+    CHECK(queue.try_pop(value));
+    CHECK_EQ(value, 42);
+}
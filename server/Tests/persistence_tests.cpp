@@ -0,0 +1,161 @@
+// Group commit, flush barriers and fsync policies of PersistenceStage
+
+#include "test.h"
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <memory>
+#include "../Project1/persistence.h"
+#include "../Project1/metrics.h"
+
+namespace
+{
+    using FsyncPolicy = PersistenceStage::FsyncPolicy;
+
+    std::string readFile(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // Durable callback that fulfils a future with its result
+    struct durableResult
+    {
+        std::shared_ptr<std::promise<bool>> promise = std::make_shared<std::promise<bool>>();
+        std::future<bool> future = promise->get_future();
+
+        PersistenceStage::DurableCallback callback()
+        {
+            auto target = promise;
+            return [target](bool ok) { target->set_value(ok); };
+        }
+
+        bool ready(std::chrono::milliseconds timeout) { return future.wait_for(timeout) == std::future_status::ready; }
+    };
+
+    uint64_t syncCount()
+    {
+        return Metrics::instance().snapshot().histogram(Metrics::HistogramId::PersistenceSync).count;
+    }
+}
+
+TEST(persistenceFlushMakesAppendsVisible)
+{
+    tests::scratchDirectory dir("persistence_flush");
+    PersistenceStage stage(FsyncPolicy::None);
+
+    std::string expectedA, expectedB;
+    for (int i = 0; i < 500; i++)
+    {
+        std::string line = std::to_string(i) + "\n";
+        stage.append("a.log", line);
+        stage.append("b.log", line + line);
+        expectedA += line;
+        expectedB += line + line;
+    }
+    stage.flush();
+
+    // Every append queued before flush() is in its file, in order
+    CHECK(readFile("a.log") == expectedA);
+    CHECK(readFile("b.log") == expectedB);
+}
+
+TEST(persistenceGroupsQueuedAppendsIntoOneBatch)
+{
+    tests::scratchDirectory dir("persistence_group");
+    PersistenceStage stage(FsyncPolicy::EveryBatch);
+
+    // Hold the writer thread in a durable callback while the next appends queue up behind it
+    std::promise<void> holding;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    stage.append("held.log", "x", [&holding, released](bool) {
+        holding.set_value();
+        released.wait();
+    });
+    holding.get_future().wait();
+
+    Metrics::Snapshot before = Metrics::instance().snapshot();
+    const int nRecords = 100;
+    for (int i = 0; i < nRecords; i++)
+        stage.append(i % 2 ? "odd.log" : "even.log", "record\n");
+    release.set_value();
+    stage.flush();
+    Metrics::Snapshot after = Metrics::instance().snapshot();
+
+    CHECK_EQ(after.counter(Metrics::CounterId::PersistenceRecords) - before.counter(Metrics::CounterId::PersistenceRecords), uint64_t(nRecords));
+    CHECK_EQ(after.counter(Metrics::CounterId::PersistenceBatches) - before.counter(Metrics::CounterId::PersistenceBatches), 1u);
+    CHECK_EQ(readFile("odd.log").size(), size_t(nRecords / 2) * 7);
+}
+
+TEST(persistenceEveryBatchSyncsBeforeAcknowledging)
+{
+    tests::scratchDirectory dir("persistence_every_batch");
+    PersistenceStage stage(FsyncPolicy::EveryBatch);
+    CHECK(stage.policy() == FsyncPolicy::EveryBatch);
+
+    uint64_t syncsBefore = syncCount();
+    durableResult result;
+    stage.append("a.log", "data", result.callback());
+    CHECK(result.ready(std::chrono::seconds(10)));
+    CHECK(result.future.get());
+    CHECK(syncCount() > syncsBefore);
+}
+
+TEST(persistenceNoneAcknowledgesWithoutSync)
+{
+    tests::scratchDirectory dir("persistence_none");
+    uint64_t syncsBefore = syncCount();
+    {
+        PersistenceStage stage(FsyncPolicy::None);
+        durableResult result;
+        stage.append("a.log", "data", result.callback());
+        CHECK(result.ready(std::chrono::seconds(10)));
+        CHECK(result.future.get());
+    }
+    CHECK_EQ(syncCount(), syncsBefore);
+}
+
+TEST(persistenceIntervalDefersAcknowledgement)
+{
+    tests::scratchDirectory dir("persistence_interval");
+    PersistenceStage stage(FsyncPolicy::Interval, 500);
+
+    durableResult result;
+    stage.append("a.log", "data", result.callback());
+
+    // The data is written at once, the acknowledgement waits for the next interval sync
+    stage.flush();
+    CHECK(readFile("a.log") == "data");
+    CHECK(!result.ready(std::chrono::milliseconds(50)));
+    CHECK(result.ready(std::chrono::seconds(10)));
+    CHECK(result.future.get());
+}
+
+TEST(persistenceReportsWriteFailure)
+{
+    tests::scratchDirectory dir("persistence_failure");
+    PersistenceStage stage(FsyncPolicy::EveryBatch);
+
+    durableResult failed;
+    durableResult written;
+    stage.append("missing/a.log", "data", failed.callback());
+    stage.append("b.log", "data", written.callback());
+    CHECK(failed.ready(std::chrono::seconds(10)));
+    CHECK(!failed.future.get());
+    CHECK(written.ready(std::chrono::seconds(10)));
+    CHECK(written.future.get());
+}
+
+TEST(persistenceDestructorWritesQueuedAppends)
+{
+    tests::scratchDirectory dir("persistence_stop");
+    durableResult result;
+    {
+        PersistenceStage stage(FsyncPolicy::Interval, 60000);
+        stage.append("a.log", "last words", result.callback());
+    }
+    CHECK(readFile("a.log") == "last words");
+    CHECK(result.ready(std::chrono::milliseconds(0)));
+    CHECK(result.future.get());
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Minimal test registry: TEST(name) defines a test case, CHECK(expr) records a failure and carries on
+// test_main.cpp runs every registered case and returns non-zero if any check failed
+namespace tests
+{
+    struct testCase
+    {
+        const char* name;
+        std::function<void()> run;
+    };
+
+    inline std::vector<testCase>& registry()
+    {
+        static std::vector<testCase> cases;
+        return cases;
+    }
+
+    inline int& failures()
+    {
+        static int count = 0;
+        return count;
+    }
+
+    struct registrar
+    {
+        registrar(const char* name, std::function<void()> run)
+        {
+            registry().push_back({ name, std::move(run) });
+        }
+    };
+
+    inline void fail(const char* file, int line, const char* expr)
+    {
+        failures()++;
+        std::printf("  FAILED %s:%d: %s\n", file, line, expr);
+    }
+
+    // Empty directory under the system temp directory, made the working directory while the object lives
+    // For code that writes files relative to the working directory, such as the chat logs; removed afterwards
+    class scratchDirectory
+    {
+    public:
+        explicit scratchDirectory(const std::string& name)
+            : previous(std::filesystem::current_path()), path(std::filesystem::temp_directory_path() / ("server_tests_" + name))
+        {
+            std::filesystem::remove_all(path);
+            std::filesystem::create_directories(path);
+            std::filesystem::current_path(path);
+        }
+
+        ~scratchDirectory()
+        {
+            std::error_code ec;
+            std::filesystem::current_path(previous, ec);
+            std::filesystem::remove_all(path, ec);
+        }
+
+        scratchDirectory(const scratchDirectory&) = delete;
+        scratchDirectory& operator=(const scratchDirectory&) = delete;
+
+    private:
+        std::filesystem::path previous;
+        std::filesystem::path path;
+    };
+}
+
+#define TEST_CONCAT_(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_(a, b)
+
+#define TEST(name) \
+    static void name(); \
+    static tests::registrar TEST_CONCAT(name, _registrar)(#name, &name); \
+    static void name()
+
+#define CHECK(expr) \
+    do { if (!(expr)) tests::fail(__FILE__, __LINE__, #expr); } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { if (!((a) == (b))) tests::fail(__FILE__, __LINE__, #a " == " #b); } while (0)
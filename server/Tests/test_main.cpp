@@ -0,0 +1,25 @@
+// Unit tests for the server's building blocks
+// Usage: Tests [filter]   (runs the test cases whose name contains filter, all by default)
+
+#include "test.h"
+#include <cstring>
+
+int main(int argc, char* argv[])
+{
+    const char* filter = argc > 1 ? argv[1] : "";
+
+    int nRun = 0;
+    for (const auto& test : tests::registry())
+    {
+        if (std::strstr(test.name, filter) == nullptr)
+            continue;
+
+        int before = tests::failures();
+        test.run();
+        nRun++;
+        std::printf("%s %s\n", tests::failures() == before ? "ok    " : "FAILED", test.name);
+    }
+
+    std::printf("%d test(s), %d failed check(s)\n", nRun, tests::failures());
+    return tests::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+// Expiry order, cancellation and cascading of olc::net::timerWheel
+
+#include "test.h"
+#include "../Project1/net_timerWheel.h"
+
+namespace
+{
+    // A wheel with a short tick driven by its own I/O thread
+    class wheelFixture
+    {
+    public:
+        explicit wheelFixture(std::chrono::milliseconds tick = std::chrono::milliseconds(1))
+            : m_work(boost::asio::make_work_guard(m_context)), wheel(m_context, tick)
+        {
+            wheel.start();
+            m_thread = std::thread([this]() { m_context.run(); });
+        }
+
+        ~wheelFixture()
+        {
+            m_work.reset();
+            m_context.stop();
+            m_thread.join();
+        }
+
+        // Waits until the wheel has no pending timers or the timeout expires
+        bool idle(std::chrono::milliseconds timeout = std::chrono::seconds(10))
+        {
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            while (wheel.size() > 0 && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return wheel.size() == 0;
+        }
+
+    private:
+        boost::asio::io_context m_context;
+        boost::asio::executor_work_guard<boost::asio::io_context::executor_type> m_work;
+
+    public:
+        olc::net::timerWheel wheel;
+
+    private:
+        std::thread m_thread;
+    };
+}
+
+TEST(timerWheelFiresInExpiryOrder)
+{
+    wheelFixture fixture;
+    std::mutex mux;
+    std::vector<int> fired;
+
+    for (int delay : { 30, 5, 20, 10 })
+    {
+        fixture.wheel.schedule(std::chrono::milliseconds(delay), [&mux, &fired, delay]()
+            {
+                std::lock_guard<std::mutex> lock(mux);
+                fired.push_back(delay);
+            });
+    }
+
+    CHECK(fixture.idle());
+    std::lock_guard<std::mutex> lock(mux);
+    CHECK((fired == std::vector<int>{ 5, 10, 20, 30 }));
+}
+
+TEST(timerWheelNeverFiresEarly)
+{
+    wheelFixture fixture;
+    auto scheduled = std::chrono::steady_clock::now();
+    std::atomic<int64_t> elapsedMs{ -1 };
+
+    fixture.wheel.schedule(std::chrono::milliseconds(25), [&elapsedMs, scheduled]()
+        {
+            elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - scheduled).count();
+        });
+
+    CHECK(fixture.idle());
+    CHECK(elapsedMs.load() >= 25);
+}
+
+TEST(timerWheelCancelledTimerDoesNotRun)
+{
+    wheelFixture fixture;
+    std::atomic<int> runs{ 0 };
+
+    auto cancelled = fixture.wheel.schedule(std::chrono::milliseconds(10), [&runs]() { runs += 100; });
+    fixture.wheel.schedule(std::chrono::milliseconds(20), [&runs]() { runs += 1; });
+    CHECK_EQ(fixture.wheel.size(), 2u);
+
+    CHECK(fixture.wheel.cancel(cancelled));
+    CHECK(!fixture.wheel.cancel(cancelled));
+    CHECK(fixture.idle());
+    CHECK_EQ(runs.load(), 1);
+}
+
+TEST(timerWheelCascadesFromHigherLevels)
+{
+    // Delays beyond one level (64 ticks) and two levels (4096 ticks) start in higher levels and move down
+    wheelFixture fixture(std::chrono::milliseconds(1));
+    std::atomic<int> fired{ 0 };
+    std::atomic<bool> inOrder{ true };
+
+    for (int delay : { 70, 130, 4200 })
+    {
+        fixture.wheel.schedule(std::chrono::milliseconds(delay), [&fired, &inOrder, delay]()
+            {
+                int expected = delay == 70 ? 0 : delay == 130 ? 1 : 2;
+                if (fired.fetch_add(1) != expected)
+                    inOrder = false;
+            });
+    }
+
+    CHECK(fixture.idle(std::chrono::seconds(30)));
+    CHECK_EQ(fired.load(), 3);
+    CHECK(inOrder.load());
+}
+
+TEST(timerWheelCallbackMayReschedule)
+{
+    wheelFixture fixture;
+    std::atomic<int> runs{ 0 };
+    std::function<void()> tick = [&]()
+        {
+            if (++runs < 3)
+                fixture.wheel.schedule(std::chrono::milliseconds(2), tick);
+        };
+
+    fixture.wheel.schedule(std::chrono::milliseconds(2), tick);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (runs.load() < 3 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    CHECK_EQ(runs.load(), 3);
+}